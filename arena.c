@@ -0,0 +1,187 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "arena.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/* Un trozo de memoria de la arena, los datos van a continuacion del encabezado */
+typedef struct _Trozo {
+	struct _Trozo* sig;
+	size_t tam;    /* bytes de datos */
+	size_t usado;
+	int externo;   /* memoria del llamador, no se libera */
+} Trozo;
+
+/* el encabezado ocupa un multiplo de la alineacion para que los datos queden alineados */
+#define TAM_ENCABEZADO ((sizeof(Trozo) + ARENA_ALINEACION - 1) & ~(size_t)(ARENA_ALINEACION - 1))
+
+/* Los pedidos salen del primer trozo de la lista, los llenos quedan detras */
+struct _Arena {
+	Trozo* trozos;
+	size_t tam_trozo;
+	int externa;   /* la arena vive en memoria del llamador (arena_crear_en) */
+	ArenaEstadisticas est;
+};
+
+/* lo que ocupa la arena al principio de la memoria de arena_crear_en */
+#define TAM_ARENA ((sizeof(struct _Arena) + ARENA_ALINEACION - 1) & ~(size_t)(ARENA_ALINEACION - 1))
+
+static Trozo* _nuevo_trozo(Arena a, size_t tam);
+
+/* Crea una arena que reserva de a tam_trozo bytes (0 = ARENA_TROZO_DEFECTO)
+retorna NULL si hubo error */
+Arena arena_crear(size_t tam_trozo) {
+	Arena a = (Arena)calloc(1, sizeof(struct _Arena));
+	if (a == NULL) return NULL;
+	a->tam_trozo = tam_trozo > 0 ? tam_trozo : ARENA_TROZO_DEFECTO;
+	a->trozos = NULL;
+	a->externa = 0;
+	return a;
+}
+
+/* Crea una arena dentro de los tam bytes de mem (memoria del llamador, no se libera)
+retorna NULL si mem no alcanza ni para la arena */
+Arena arena_crear_en(void* mem, size_t tam) {
+	// alinear el inicio, despues va la arena y el resto es un solo trozo
+	size_t corrimiento = (ARENA_ALINEACION - (size_t)mem % ARENA_ALINEACION) % ARENA_ALINEACION;
+	if (mem == NULL || tam < corrimiento + TAM_ARENA + TAM_ENCABEZADO + ARENA_ALINEACION) return NULL;
+	Arena a = (Arena)((unsigned char*)mem + corrimiento);
+	Trozo* t = (Trozo*)((unsigned char*)a + TAM_ARENA);
+	t->sig = NULL;
+	t->tam = (tam - corrimiento - TAM_ARENA - TAM_ENCABEZADO) & ~(size_t)(ARENA_ALINEACION - 1);
+	t->usado = 0;
+	t->externo = 1;
+	a->trozos = t;
+	a->tam_trozo = ARENA_TROZO_DEFECTO;
+	a->externa = 1;
+	a->est.pedidos = 0;
+	a->est.reservas = 0;
+	a->est.usados = 0;
+	a->est.reservados = t->tam;
+	a->est.pico = t->tam;
+	return a;
+}
+
+/* Entrega n bytes alineados a ARENA_ALINEACION, validos hasta arena_vaciar
+retorna NULL si hubo error */
+void* arena_pedir(Arena a, size_t n) {
+	if (a == NULL) return NULL;
+	n = (n + ARENA_ALINEACION - 1) & ~(size_t)(ARENA_ALINEACION - 1);
+	if (n == 0) n = ARENA_ALINEACION;
+
+	Trozo* t = a->trozos;
+	if (t == NULL || t->tam - t->usado < n) {
+		// los pedidos mas grandes que un trozo reciben un trozo propio,
+		// que va detras del actual para no perder lo que le queda libre
+		t = _nuevo_trozo(a, n > a->tam_trozo ? n : a->tam_trozo);
+		if (t == NULL) return NULL;
+		if (n > a->tam_trozo && t->sig != NULL) {
+			a->trozos = t->sig;
+			t->sig = a->trozos->sig;
+			a->trozos->sig = t;
+		}
+	}
+	void* p = (unsigned char*)t + TAM_ENCABEZADO + t->usado;
+	t->usado += n;
+	a->est.pedidos++;
+	a->est.usados += n;
+	return p;
+}
+
+/* Libera de una vez todo lo entregado. Se queda con un solo trozo del tamano
+de todo lo que tenia reservado, asi la proxima vuelta no llama a malloc */
+void arena_vaciar(Arena a) {
+	if (a == NULL) return;
+	Trozo* t = a->trozos;
+	if (a->externa) {
+		// la memoria del llamador queda, los trozos que se agregaron se liberan
+		Trozo* externo = NULL;
+		while (t != NULL) {
+			Trozo* sig = t->sig;
+			if (t->externo) externo = t;
+			else {
+				a->est.reservados -= t->tam;
+				free(t);
+			}
+			t = sig;
+		}
+		externo->sig = NULL;
+		externo->usado = 0;
+		a->trozos = externo;
+		a->est.usados = 0;
+		return;
+	}
+	if (t != NULL && t->sig != NULL) {
+		// varios trozos: se cambian por uno solo con lugar para todo
+		size_t total = 0;
+		while (t != NULL) {
+			Trozo* sig = t->sig;
+			total += t->tam;
+			free(t);
+			t = sig;
+		}
+		a->trozos = NULL;
+		a->est.reservados = 0;
+		t = _nuevo_trozo(a, total);
+	}
+	if (t != NULL) t->usado = 0;
+	a->est.usados = 0;
+}
+
+/* Libera la arena y toda su memoria */
+void arena_destruir(Arena a) {
+	if (a == NULL) return;
+	Trozo* t = a->trozos;
+	while (t != NULL) {
+		Trozo* sig = t->sig;
+		if (!t->externo) free(t);
+		t = sig;
+	}
+	if (!a->externa) free(a);
+}
+
+/* Copia las estadisticas de la arena en e */
+void arena_estadisticas(Arena a, ArenaEstadisticas* e) {
+	if (a == NULL || e == NULL) return;
+	*e = a->est;
+}
+
+/* retorna la memoria maxima que uso el proceso (pico de RSS) en bytes, 0 si no se puede saber */
+size_t arena_pico_proceso(void) {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+	return (size_t)pmc.PeakWorkingSetSize;
+#else
+	struct rusage uso;
+	if (getrusage(RUSAGE_SELF, &uso) != 0) return 0;
+#ifdef __APPLE__
+	return (size_t)uso.ru_maxrss; // en macOS ya esta en bytes
+#else
+	return (size_t)uso.ru_maxrss * 1024; // en Linux esta en KiB
+#endif
+#endif
+}
+
+// FUNCIONES ADICIONALES -----------
+
+/* Reserva un trozo de tam bytes de datos y lo pone primero en la lista
+retorna NULL si hubo error */
+static Trozo* _nuevo_trozo(Arena a, size_t tam) {
+	Trozo* t = (Trozo*)malloc(TAM_ENCABEZADO + tam);
+	if (t == NULL) return NULL;
+	t->tam = tam;
+	t->usado = 0;
+	t->externo = 0;
+	t->sig = a->trozos;
+	a->trozos = t;
+	a->est.reservas++;
+	a->est.reservados += tam;
+	if (a->est.reservados > a->est.pico) a->est.pico = a->est.reservados;
+	return t;
+}
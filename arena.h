@@ -0,0 +1,59 @@
+#ifndef DEFINE_ARENA_H
+#define DEFINE_ARENA_H
+
+#include <stddef.h>
+
+/*Definicion del API de la arena de memoria, la implementacion va en arena.c*/
+
+/*
+  Una Arena entrega memoria avanzando un puntero dentro de trozos grandes,
+  sin un malloc por cada pedido. Lo que se pide no se libera de a uno:
+  arena_vaciar devuelve todo de una vez (por ejemplo al terminar un bloque
+  o un arbol) y la arena se puede volver a usar sin pedir memoria de nuevo.
+  No es segura entre hilos: cada hilo o bloque usa su propia arena.
+*/
+
+/* tamano de cada trozo si arena_crear recibe 0 */
+#define ARENA_TROZO_DEFECTO (64 * 1024)
+
+/* alineacion de lo que entrega arena_pedir */
+#define ARENA_ALINEACION 16
+
+typedef struct _Arena* Arena;
+
+/* Estadisticas de una arena, ver arena_estadisticas */
+typedef struct _ArenaEstadisticas {
+	unsigned long long pedidos;  /* llamadas a arena_pedir */
+	unsigned long long reservas; /* llamadas a malloc hechas por la arena */
+	size_t usados;               /* bytes entregados desde el ultimo arena_vaciar */
+	size_t reservados;           /* bytes que la arena tiene pedidos al sistema ahora */
+	size_t pico;                 /* maximo de reservados desde que se creo */
+} ArenaEstadisticas;
+
+/* Crea una arena que reserva de a tam_trozo bytes (0 = ARENA_TROZO_DEFECTO)
+retorna NULL si hubo error */
+Arena arena_crear(size_t tam_trozo);
+
+/* Crea una arena dentro de los tam bytes de mem (memoria del llamador, no se libera).
+Si se llena sigue pidiendo trozos con malloc como arena_crear
+retorna NULL si mem no alcanza ni para la arena */
+Arena arena_crear_en(void* mem, size_t tam);
+
+/* Entrega n bytes alineados a ARENA_ALINEACION, validos hasta arena_vaciar
+retorna NULL si hubo error */
+void* arena_pedir(Arena a, size_t n);
+
+/* Libera de una vez todo lo entregado. Se queda con un solo trozo del tamano
+de todo lo que tenia reservado, asi la proxima vuelta no llama a malloc */
+void arena_vaciar(Arena a);
+
+/* Libera la arena y toda su memoria */
+void arena_destruir(Arena a);
+
+/* Copia las estadisticas de la arena en e */
+void arena_estadisticas(Arena a, ArenaEstadisticas* e);
+
+/* retorna la memoria maxima que uso el proceso (pico de RSS) en bytes, 0 si no se puede saber */
+size_t arena_pico_proceso(void);
+
+#endif
@@ -0,0 +1,618 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "benchmark.h"
+#include <stdlib.h>
+#include <string.h>
+#include "huffman_opciones.h"
+#include "arena.h"
+#include "mapeo.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* despues de windows.h, que tambien define BOOLEAN */
+#include "pq.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define _LEER_CICLOS() __rdtsc()
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define _LEER_CICLOS() __rdtsc()
+#else
+#define _LEER_CICLOS() 0ULL
+#endif
+
+/* una variante de opciones que se mide en cada corpus */
+typedef struct _VarianteBenchmark {
+	const char* nombre;
+	int modo;
+	int max_longitud;
+	int constructor;
+	int flujos;
+	int hilos;  /* 1 = con memoria de trabajo en el hilo que llama, 0 = sin ella y un hilo por procesador */
+} VarianteBenchmark;
+
+static const VarianteBenchmark VARIANTES[] = {
+	{ "arbol", MODO_ARBOL, 0, CONSTRUCTOR_PQ, 1, 1 },
+	{ "canonico", MODO_CANONICO, 0, CONSTRUCTOR_PQ, 1, 1 },
+	{ "lineal", MODO_CANONICO, 0, CONSTRUCTOR_LINEAL, 1, 1 },
+	{ "limitado12", MODO_CANONICO, 12, CONSTRUCTOR_PQ, 1, 1 },
+	{ "contexto", MODO_CONTEXTO, 0, CONSTRUCTOR_PQ, 1, 1 },
+	{ "simbolos16", MODO_SIMBOLOS16, 0, CONSTRUCTOR_LINEAL, 1, 1 },
+	{ "bloques", MODO_BLOQUES, 0, CONSTRUCTOR_PQ, 1, 1 },
+	{ "bloques4", MODO_BLOQUES, 0, CONSTRUCTOR_PQ, 4, 1 },
+	{ "bloques4_hilos", MODO_BLOQUES, 0, CONSTRUCTOR_PQ, 4, 0 },
+};
+#define NUM_VARIANTES ((int)(sizeof(VARIANTES) / sizeof(VARIANTES[0])))
+
+static const int TAMANOS_PQ[NUM_TAMANOS_PQ] = { 256, 65536, 1 << 20 };
+
+static const char* NOMBRES_ETAPAS[NUM_ETAPAS] = {
+	"calcular_frecuencias", "crear_huffman", "crear_tabla", "codificar", "decodificar"
+};
+
+/* La cola de prioridades original (antes del arreglo en linea y la aridad),
+para comparar: un malloc por PrioValue, monticulo binario desde arr[1] y
+capacidad fija. Tiene un lugar mas que la original, que escribia arr[cap] */
+typedef struct _PQOriginal {
+	PrioValue* arr;
+	int cap;
+	int size;
+} *PQOriginal;
+
+/* buffers que se reusan entre corpus */
+typedef struct _Buffers {
+	unsigned char* comprimido;
+	size_t cap_comprimido;
+	unsigned char* salida;
+	size_t cap_salida;
+	void* trabajo;
+} Buffers;
+
+static int _medir_corpus(const char* corpus, const unsigned char* datos, size_t n, const OpcionesBenchmark* op, Buffers* b, FILE* out);
+static void _escribir_medicion(FILE* out, int formato, const char* corpus, const char* variante, const char* operacion,
+	size_t bytes, long long comprimido, MedicionBenchmark m, int ok);
+static int _preparar(unsigned char** p, size_t* cap, size_t tam);
+static void _anotar(MedicionBenchmark* m, int r, double segundos, unsigned long long ciclos);
+static int _vaciar_pq(PQ pq, int n);
+static int _medir_pq_original(const struct _PrioValue* elementos, int n, const OpcionesBenchmark* op, FILE* out);
+static PQOriginal _original_crear(void);
+static BOOLEAN _original_agregar(PQOriginal pq, void* valor, int prioridad, int es_arbol);
+static BOOLEAN _original_sacar(PQOriginal pq, void** retVal);
+static void _original_destruir(PQOriginal pq);
+static void _original_subir(PQOriginal pq, int i);
+static void _original_bajar(PQOriginal pq, int i);
+static unsigned long long _azar(unsigned long long* estado);
+
+/* Llena op con los valores por defecto */
+void benchmark_opciones_defecto(OpcionesBenchmark* op) {
+	if (op == NULL) return;
+	op->tam_sintetico = 1 << 20;
+	op->repeticiones = 5;
+	op->formato = BENCHMARK_JSON;
+}
+
+/* retorna el nombre del corpus sintetico tipo, NULL si no existe */
+const char* benchmark_nombre_corpus(int tipo) {
+	switch (tipo) {
+	case CORPUS_TEXTO: return "texto";
+	case CORPUS_BINARIO: return "binario";
+	case CORPUS_SESGADO: return "sesgado";
+	case CORPUS_UNIFORME: return "uniforme";
+	case CORPUS_UN_SIMBOLO: return "un_simbolo";
+	case CORPUS_MUESTRAS16: return "muestras16";
+	default: return NULL;
+	}
+}
+
+/* Llena los n bytes de datos con el corpus sintetico tipo
+retorna 0 si no hay errores */
+int benchmark_corpus(int tipo, unsigned char* datos, size_t n) {
+	static const char* palabras[] = {
+		"de", "la", "que", "el", "en", "y", "a", "los", "se", "del", "las", "un", "por", "con", "no", "una",
+		"su", "para", "es", "al", "lo", "como", "mas", "pero", "sus", "le", "ya", "o", "arbol", "codigo", "bits", "huffman"
+	};
+	if (datos == NULL && n > 0) return 1;
+	unsigned long long estado = 0x9E3779B97F4A7C15ULL + (unsigned long long)tipo;
+	size_t i = 0;
+
+	switch (tipo) {
+	case CORPUS_TEXTO:
+		// las palabras del principio de la lista salen mas seguido (el minimo de dos sorteos)
+		while (i < n) {
+			unsigned long long r = _azar(&estado);
+			unsigned int a = (unsigned int)(r & 31);
+			unsigned int b = (unsigned int)((r >> 5) & 31);
+			const char* p = palabras[a < b ? a : b];
+			while (*p != '\0' && i < n) datos[i++] = (unsigned char)*p++;
+			if (i < n) datos[i++] = ((r >> 10) & 15) == 0 ? '\n' : ' ';
+		}
+		return 0;
+	case CORPUS_BINARIO:
+		// registros de 8 bytes: contador de 32 bits, entero chico de 16 bits, banderas y relleno
+		for (unsigned int k = 0; i < n; k++) {
+			unsigned long long r = _azar(&estado);
+			unsigned char registro[8];
+			registro[0] = (unsigned char)k;
+			registro[1] = (unsigned char)(k >> 8);
+			registro[2] = (unsigned char)(k >> 16);
+			registro[3] = (unsigned char)(k >> 24);
+			registro[4] = (unsigned char)(r % 100);
+			registro[5] = 0;
+			registro[6] = (unsigned char)(1u << ((r >> 8) & 3));
+			registro[7] = 0;
+			for (int j = 0; j < 8 && i < n; j++) datos[i++] = registro[j];
+		}
+		return 0;
+	case CORPUS_SESGADO:
+		// 'a' con probabilidad 1/2, 'b' 1/4, 'c' 1/8... (ceros seguidos de un numero al azar)
+		for (; i < n; i++) {
+			unsigned long long r = _azar(&estado);
+			int ceros = 0;
+			while (ceros < 25 && (r & 1) == 0) {
+				r >>= 1;
+				ceros++;
+			}
+			datos[i] = (unsigned char)('a' + ceros);
+		}
+		return 0;
+	case CORPUS_UNIFORME:
+		for (; i < n; i++) {
+			datos[i] = (unsigned char)(_azar(&estado) >> 56);
+		}
+		return 0;
+	case CORPUS_UN_SIMBOLO:
+		if (n > 0) memset(datos, 'a', n);
+		return 0;
+	case CORPUS_MUESTRAS16: {
+		// la senal se mueve de a poco y cada lectura tiene un ruido de +-3
+		int senal = 30000;
+		for (; i < n; i += 2) {
+			unsigned long long r = _azar(&estado);
+			senal += (int)(r % 41) - 20;
+			if (senal < 100) senal = 100;
+			if (senal > 65000) senal = 65000;
+			unsigned int muestra = (unsigned int)(senal + (int)((r >> 8) % 7) - 3);
+			datos[i] = (unsigned char)muestra;
+			if (i + 1 < n) datos[i + 1] = (unsigned char)(muestra >> 8);
+		}
+		return 0;
+	}
+	default:
+		return 1;
+	}
+}
+
+/*
+  Corre el benchmark sobre los corpus sinteticos y los num archivos.
+  Los archivos se mapean (ver mapeo.h); los que no se pueden abrir cuentan como falla.
+  retorna 0 si todas las mediciones terminaron bien
+*/
+int benchmark_ejecutar(char** archivos, int num, const OpcionesBenchmark* op, FILE* out) {
+	OpcionesBenchmark defecto;
+	if (op == NULL) {
+		benchmark_opciones_defecto(&defecto);
+		op = &defecto;
+	}
+	if (out == NULL || op->repeticiones <= 0 || (num > 0 && archivos == NULL)) return 1;
+
+	Buffers b = { NULL, 0, NULL, 0, NULL };
+	b.trabajo = malloc(MEMORIA_TRABAJO);
+	if (b.trabajo == NULL) return 1;
+	if (op->formato == BENCHMARK_CSV) {
+		fprintf(out, "corpus,variante,operacion,bytes,comprimido,razon,segundos,mb_s,ns_byte,ciclos_byte,pico_bytes,ok\n");
+	}
+
+	int error = 0;
+	if (op->tam_sintetico > 0) {
+		unsigned char* datos = malloc(op->tam_sintetico);
+		if (datos == NULL) error = 1;
+		for (int tipo = 0; datos != NULL && tipo < NUM_CORPUS; tipo++) {
+			benchmark_corpus(tipo, datos, op->tam_sintetico);
+			error |= _medir_corpus(benchmark_nombre_corpus(tipo), datos, op->tam_sintetico, op, &b, out);
+		}
+		free(datos);
+		for (int t = 0; t < NUM_TAMANOS_PQ; t++) {
+			error |= benchmark_pq(TAMANOS_PQ[t], op, out);
+		}
+	}
+	for (int i = 0; i < num; i++) {
+		Mapeo m = mapeo_abrir(archivos[i]);
+		if (m == NULL) {
+			fprintf(stderr, "No se puede abrir %s\n", archivos[i]);
+			error = 1;
+			continue;
+		}
+		error |= _medir_corpus(archivos[i], m->datos, m->tam, op, &b, out);
+		mapeo_cerrar(m);
+	}
+
+	free(b.comprimido);
+	free(b.salida);
+	free(b.trabajo);
+	return error;
+}
+
+/*
+  Mide pq_add, pq_remove y pq_heapify con n prioridades al azar.
+  Cada repeticion usa una cola nueva, asi el tiempo de pq_add incluye agrandar el arreglo.
+  retorna 0 si no hay errores
+*/
+int benchmark_pq(int n, const OpcionesBenchmark* op, FILE* out) {
+	OpcionesBenchmark defecto;
+	if (op == NULL) {
+		benchmark_opciones_defecto(&defecto);
+		op = &defecto;
+	}
+	if (out == NULL || n <= 0 || op->repeticiones <= 0) return 1;
+
+	struct _PrioValue* elementos = malloc(sizeof(struct _PrioValue) * (size_t)n);
+	if (elementos == NULL) return 1;
+	unsigned long long estado = 0x9E3779B97F4A7C15ULL;
+	for (int i = 0; i < n; i++) {
+		elementos[i].prio = (int)(_azar(&estado) >> 33); // 31 bits, nunca negativa
+		elementos[i].es_arbol = FALSE;
+		elementos[i].value = &elementos[i]; // pq_add no acepta NULL
+	}
+
+	MedicionBenchmark agregar = { 0, 0 };
+	MedicionBenchmark sacar = { 0, 0 };
+	MedicionBenchmark heapify = { 0, 0 };
+	int ok = 1;
+	for (int r = 0; ok && r < op->repeticiones; r++) {
+		PQ pq = pq_create();
+		if (pq == NULL) {
+			ok = 0;
+			break;
+		}
+		double t0 = benchmark_reloj();
+		unsigned long long c0 = benchmark_ciclos();
+		for (int i = 0; i < n; i++) {
+			ok &= pq_add(pq, elementos[i].value, elementos[i].prio, elementos[i].es_arbol);
+		}
+		unsigned long long c1 = benchmark_ciclos();
+		double t1 = benchmark_reloj();
+		ok &= _vaciar_pq(pq, n);
+		unsigned long long c2 = benchmark_ciclos();
+		double t2 = benchmark_reloj();
+		pq_destroy(pq);
+		_anotar(&agregar, r, t1 - t0, c1 - c0);
+		_anotar(&sacar, r, t2 - t1, c2 - c1);
+
+		pq = pq_create();
+		if (pq == NULL) {
+			ok = 0;
+			break;
+		}
+		t0 = benchmark_reloj();
+		c0 = benchmark_ciclos();
+		ok &= pq_heapify(pq, elementos, n);
+		c1 = benchmark_ciclos();
+		t1 = benchmark_reloj();
+		// se vacia fuera del tiempo, solo para ver que quedo ordenado
+		ok &= _vaciar_pq(pq, n);
+		pq_destroy(pq);
+		_anotar(&heapify, r, t1 - t0, c1 - c0);
+	}
+
+	char variante[32];
+	sprintf(variante, "aridad%d", PQ_ARIDAD);
+	_escribir_medicion(out, op->formato, "pq", variante, "pq_add", (size_t)n, -1, agregar, ok);
+	_escribir_medicion(out, op->formato, "pq", variante, "pq_remove", (size_t)n, -1, sacar, ok);
+	_escribir_medicion(out, op->formato, "pq", variante, "pq_heapify", (size_t)n, -1, heapify, ok);
+	if (n <= BENCHMARK_PQ_ORIGINAL) {
+		ok &= _medir_pq_original(elementos, n, op, out) == 0;
+	}
+	free(elementos);
+	fflush(out);
+	return !ok;
+}
+
+/* retorna un reloj monotono en segundos */
+double benchmark_reloj(void) {
+#ifdef _WIN32
+	LARGE_INTEGER frecuencia, ahora;
+	QueryPerformanceFrequency(&frecuencia);
+	QueryPerformanceCounter(&ahora);
+	return (double)ahora.QuadPart / (double)frecuencia.QuadPart;
+#else
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+#endif
+}
+
+/* retorna el tiempo de CPU del hilo que llama en segundos */
+double benchmark_reloj_cpu(void) {
+#ifdef _WIN32
+	FILETIME creacion, fin, nucleo, usuario;
+	if (!GetThreadTimes(GetCurrentThread(), &creacion, &fin, &nucleo, &usuario)) return 0;
+	// en unidades de 100 ns
+	unsigned long long t = ((unsigned long long)nucleo.dwHighDateTime << 32 | nucleo.dwLowDateTime) +
+		((unsigned long long)usuario.dwHighDateTime << 32 | usuario.dwLowDateTime);
+	return (double)t * 1e-7;
+#else
+	struct timespec t;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) != 0) return 0;
+	return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+#endif
+}
+
+/* retorna el contador de ciclos del procesador, 0 si no hay uno */
+unsigned long long benchmark_ciclos(void) {
+	return _LEER_CICLOS();
+}
+
+// FUNCIONES ADICIONALES -----------
+
+/*
+  Mide un corpus: ida y vuelta por memoria con cada variante y despues las etapas.
+  retorna 0 si todas las mediciones terminaron bien
+*/
+static int _medir_corpus(const char* corpus, const unsigned char* datos, size_t n, const OpcionesBenchmark* op, Buffers* b, FILE* out) {
+	int error = 0;
+	if (_preparar(&b->salida, &b->cap_salida, n) != 0) return 1;
+
+	for (int v = 0; v < NUM_VARIANTES; v++) {
+		const VarianteBenchmark* var = &VARIANTES[v];
+		OpcionesHuffman oh;
+		opciones_defecto(&oh);
+		oh.modo = var->modo;
+		oh.max_longitud = var->max_longitud;
+		oh.constructor = var->constructor;
+		oh.flujos = var->flujos;
+		oh.hilos = var->hilos;
+		void* trabajo = var->hilos == 1 ? b->trabajo : NULL;
+		size_t tam_trabajo = trabajo != NULL ? MEMORIA_TRABAJO : 0;
+		if (_preparar(&b->comprimido, &b->cap_comprimido, comprimir_cota(n, &oh)) != 0) return 1;
+
+		MedicionBenchmark c = { 0, 0 };
+		MedicionBenchmark d = { 0, 0 };
+		long long tam = -1;
+		long long descomprimido = -1;
+		for (int r = 0; r < op->repeticiones; r++) {
+			double t0 = benchmark_reloj();
+			unsigned long long c0 = benchmark_ciclos();
+			tam = comprimir_memoria(datos, n, b->comprimido, b->cap_comprimido, &oh, trabajo, tam_trabajo);
+			unsigned long long c1 = benchmark_ciclos();
+			double t1 = benchmark_reloj();
+			if (tam < 0) break;
+			descomprimido = descomprimir_memoria(b->comprimido, (size_t)tam, b->salida, n, trabajo, tam_trabajo);
+			unsigned long long c2 = benchmark_ciclos();
+			double t2 = benchmark_reloj();
+			if (r == 0 || t1 - t0 < c.segundos) {
+				c.segundos = t1 - t0;
+				c.ciclos = c1 - c0;
+			}
+			if (r == 0 || t2 - t1 < d.segundos) {
+				d.segundos = t2 - t1;
+				d.ciclos = c2 - c1;
+			}
+		}
+		int ok_c = tam >= 0;
+		int ok_d = ok_c && descomprimido == (long long)n && (n == 0 || memcmp(datos, b->salida, n) == 0);
+		_escribir_medicion(out, op->formato, corpus, var->nombre, "comprimir", n, tam, c, ok_c);
+		_escribir_medicion(out, op->formato, corpus, var->nombre, "descomprimir", n, tam, d, ok_d);
+		error |= !ok_d;
+	}
+
+	MedicionBenchmark etapas[NUM_ETAPAS];
+	int ok = huffman_medir_etapas(datos, n, op->repeticiones, etapas) == 0;
+	for (int e = 0; e < NUM_ETAPAS; e++) {
+		_escribir_medicion(out, op->formato, corpus, "etapas", NOMBRES_ETAPAS[e], n, -1, etapas[e], ok);
+	}
+	error |= !ok;
+	fflush(out);
+	return error;
+}
+
+/* Escribe una linea con la medicion en formato JSON o CSV
+(comprimido -1 = no aplica, ciclos 0 = no se pudieron contar: quedan null o vacios) */
+static void _escribir_medicion(FILE* out, int formato, const char* corpus, const char* variante, const char* operacion,
+	size_t bytes, long long comprimido, MedicionBenchmark m, int ok) {
+	double mb_s = m.segundos > 0 ? (double)bytes / m.segundos / (1024.0 * 1024.0) : 0;
+	double ns_byte = bytes > 0 ? m.segundos * 1e9 / (double)bytes : 0;
+	double ciclos_byte = bytes > 0 ? (double)m.ciclos / (double)bytes : 0;
+	double razon = comprimido > 0 ? (double)bytes / (double)comprimido : 0;
+	size_t pico = arena_pico_proceso();
+	char tam[32] = "";
+	char r[32] = "";
+	char cb[32] = "";
+	if (comprimido >= 0) {
+		sprintf(tam, "%lld", comprimido);
+		sprintf(r, "%.4f", razon);
+	}
+	if (m.ciclos > 0) {
+		sprintf(cb, "%.3f", ciclos_byte);
+	}
+
+	if (formato == BENCHMARK_CSV) {
+		fprintf(out, "%s,%s,%s,%llu,%s,%s,%.6f,%.2f,%.3f,%s,%llu,%d\n", corpus, variante, operacion,
+			(unsigned long long)bytes, tam, r, m.segundos, mb_s, ns_byte, cb, (unsigned long long)pico, ok);
+		return;
+	}
+	fputs("{\"corpus\":\"", out);
+	// el nombre de un archivo puede tener comillas o barras
+	for (const char* p = corpus; *p != '\0'; p++) {
+		if (*p == '"' || *p == '\\') fputc('\\', out);
+		fputc(*p, out);
+	}
+	fprintf(out, "\",\"variante\":\"%s\",\"operacion\":\"%s\",\"bytes\":%llu,\"comprimido\":%s,\"razon\":%s,"
+		"\"segundos\":%.6f,\"mb_s\":%.2f,\"ns_byte\":%.3f,\"ciclos_byte\":%s,\"pico_bytes\":%llu,\"ok\":%s}\n",
+		variante, operacion, (unsigned long long)bytes, tam[0] ? tam : "null", r[0] ? r : "null",
+		m.segundos, mb_s, ns_byte, cb[0] ? cb : "null", (unsigned long long)pico, ok ? "true" : "false");
+}
+
+/* Agranda *p a por lo menos tam bytes (al menos 1)
+retorna 0 si no hay errores */
+static int _preparar(unsigned char** p, size_t* cap, size_t tam) {
+	if (tam == 0) tam = 1;
+	if (*cap >= tam) return 0;
+	unsigned char* nuevo = realloc(*p, tam);
+	if (nuevo == NULL) return 1;
+	*p = nuevo;
+	*cap = tam;
+	return 0;
+}
+
+/* Guarda en m la medicion de la repeticion r si es la primera o la mejor */
+static void _anotar(MedicionBenchmark* m, int r, double segundos, unsigned long long ciclos) {
+	if (r == 0 || segundos < m->segundos) {
+		m->segundos = segundos;
+		m->ciclos = ciclos;
+	}
+}
+
+/* Saca los n elementos de pq
+retorna 1 si salieron los n en orden de prioridad y la cola quedo vacia */
+static int _vaciar_pq(PQ pq, int n) {
+	struct _PrioValue pv;
+	int anterior = 0;
+	int ok = 1;
+	for (int i = 0; i < n; i++) {
+		if (!pq_remove(pq, &pv)) return 0;
+		ok &= pv.prio >= anterior;
+		anterior = pv.prio;
+	}
+	return ok && pq_size(pq) == 0;
+}
+
+/*
+  Mide n agregar seguidos de n sacar en la cola original (no tiene heapify)
+  y escribe las dos lineas con variante "original".
+  retorna 0 si no hay errores (y salen en orden)
+*/
+static int _medir_pq_original(const struct _PrioValue* elementos, int n, const OpcionesBenchmark* op, FILE* out) {
+	MedicionBenchmark agregar = { 0, 0 };
+	MedicionBenchmark sacar = { 0, 0 };
+	int ok = 1;
+	for (int r = 0; ok && r < op->repeticiones; r++) {
+		PQOriginal pq = _original_crear();
+		if (pq == NULL) {
+			ok = 0;
+			break;
+		}
+		double t0 = benchmark_reloj();
+		unsigned long long c0 = benchmark_ciclos();
+		for (int i = 0; i < n; i++) {
+			ok &= _original_agregar(pq, elementos[i].value, elementos[i].prio, elementos[i].es_arbol);
+		}
+		unsigned long long c1 = benchmark_ciclos();
+		double t1 = benchmark_reloj();
+		// como en el crear_huffman original, cada PrioValue que sale se libera
+		int anterior = 0;
+		for (int i = 0; i < n; i++) {
+			void* p = NULL;
+			if (!_original_sacar(pq, &p)) {
+				ok = 0;
+				break;
+			}
+			PrioValue pv = (PrioValue)p;
+			ok &= pv->prio >= anterior;
+			anterior = pv->prio;
+			free(pv);
+		}
+		unsigned long long c2 = benchmark_ciclos();
+		double t2 = benchmark_reloj();
+		_original_destruir(pq);
+		_anotar(&agregar, r, t1 - t0, c1 - c0);
+		_anotar(&sacar, r, t2 - t1, c2 - c1);
+	}
+	_escribir_medicion(out, op->formato, "pq", "original", "pq_add", (size_t)n, -1, agregar, ok);
+	_escribir_medicion(out, op->formato, "pq", "original", "pq_remove", (size_t)n, -1, sacar, ok);
+	return !ok;
+}
+
+/* Crea la cola original
+retorna NULL si hubo error */
+static PQOriginal _original_crear(void) {
+	PQOriginal pq = (PQOriginal)malloc(sizeof(struct _PQOriginal));
+	if (pq == NULL) return NULL;
+	pq->arr = malloc(sizeof(PrioValue) * (BENCHMARK_PQ_ORIGINAL + 1));
+	if (pq->arr == NULL) {
+		free(pq);
+		return NULL;
+	}
+	pq->cap = BENCHMARK_PQ_ORIGINAL;
+	pq->size = 0;
+	return pq;
+}
+
+/* pq_add original: un malloc por PrioValue, va en arr[size + 1]
+retorna TRUE si tuvo exito, FALSE si no */
+static BOOLEAN _original_agregar(PQOriginal pq, void* valor, int prioridad, int es_arbol) {
+	if (pq == NULL || valor == NULL || prioridad < 0) return FALSE;
+	if (pq->size == pq->cap) return FALSE;
+	PrioValue pv = (PrioValue)malloc(sizeof(struct _PrioValue));
+	if (pv == NULL) return FALSE;
+	pv->value = valor;
+	pv->prio = prioridad;
+	pv->es_arbol = es_arbol;
+	int nuevo = pq->size + 1;
+	pq->arr[nuevo] = pv;
+	pq->size = nuevo;
+	_original_subir(pq, nuevo);
+	return TRUE;
+}
+
+/* pq_remove original: entrega el PrioValue de la cima, lo libera el que llama
+retorna FALSE si hubo error o la cola esta vacia */
+static BOOLEAN _original_sacar(PQOriginal pq, void** retVal) {
+	if (pq == NULL || retVal == NULL || pq->size == 0) return FALSE;
+	*retVal = pq->arr[1];
+	pq->arr[1] = pq->arr[pq->size];
+	pq->size--;
+	_original_bajar(pq, 1);
+	return TRUE;
+}
+
+/* Libera la cola original y los PrioValue que queden */
+static void _original_destruir(PQOriginal pq) {
+	if (pq == NULL) return;
+	for (int i = 1; i <= pq->size; i++) {
+		free(pq->arr[i]);
+	}
+	free(pq->arr);
+	free(pq);
+}
+
+/* _percolate_up original, recursivo con intercambios */
+static void _original_subir(PQOriginal pq, int i) {
+	if (i <= 1) return;
+	int pa = i / 2;
+	if (pq->arr[pa]->prio > pq->arr[i]->prio) {
+		PrioValue temp = pq->arr[pa];
+		pq->arr[pa] = pq->arr[i];
+		pq->arr[i] = temp;
+		_original_subir(pq, pa);
+	}
+}
+
+/* _percolate_down original, recursivo con intercambios */
+static void _original_bajar(PQOriginal pq, int i) {
+	if (i >= pq->size) return;
+	int izq = i * 2;
+	int der = i * 2 + 1;
+	int menor = i;
+	if (izq <= pq->size && pq->arr[izq]->prio < pq->arr[menor]->prio) menor = izq;
+	if (der <= pq->size && pq->arr[der]->prio < pq->arr[menor]->prio) menor = der;
+	if (menor != i) {
+		PrioValue temp = pq->arr[i];
+		pq->arr[i] = pq->arr[menor];
+		pq->arr[menor] = temp;
+		_original_bajar(pq, menor);
+	}
+}
+
+/* xorshift64*: numeros al azar rapidos y repetibles, asi los corpus son siempre iguales */
+static unsigned long long _azar(unsigned long long* estado) {
+	unsigned long long x = *estado;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*estado = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
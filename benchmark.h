@@ -0,0 +1,108 @@
+#ifndef DEFINE_BENCHMARK_H
+#define DEFINE_BENCHMARK_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*Definicion del API del benchmark del compresor, la implementacion va en benchmark.c*/
+
+/*
+  Mide el compresor sobre corpus sinteticos (texto, binario, sesgado, uniforme,
+  un solo simbolo, muestras de 16 bits) y archivos reales. Para cada corpus y cada variante de
+  opciones (arbol, canonico, lineal, limitado, bloques...) se mide
+  comprimir_memoria y descomprimir_memoria, y despues cada etapa interna
+  (ver huffman_medir_etapas). Tambien se mide la cola de prioridades (ver
+  benchmark_pq). De cada medicion se reporta el mejor tiempo de las
+  repeticiones: MB/s, ns y ciclos por byte (por elemento en la cola de
+  prioridades), razon de compresion y pico de memoria.
+  La salida es una linea por medicion en JSON (un objeto por linea) o CSV,
+  para comparar variantes o detectar regresiones con otro programa.
+*/
+
+/* corpus sinteticos */
+#define CORPUS_TEXTO 0      /* palabras con frecuencias de texto */
+#define CORPUS_BINARIO 1    /* registros binarios: contadores, enteros chicos, banderas */
+#define CORPUS_SESGADO 2    /* distribucion geometrica, cada simbolo la mitad de probable que el anterior */
+#define CORPUS_UNIFORME 3   /* bytes al azar, no se puede comprimir */
+#define CORPUS_UN_SIMBOLO 4 /* un solo byte repetido */
+#define CORPUS_MUESTRAS16 5 /* muestras de 16 bits de un sensor (little endian): paseo al azar con ruido */
+#define NUM_CORPUS 6
+
+/* formatos de salida */
+#define BENCHMARK_JSON 0
+#define BENCHMARK_CSV 1
+
+/* etapas internas que mide huffman_medir_etapas */
+#define ETAPA_FRECUENCIAS 0  /* calcular_frecuencias (el histograma, en memoria) */
+#define ETAPA_ARBOL 1        /* crear_huffman */
+#define ETAPA_TABLA 2        /* crear_tabla */
+#define ETAPA_CODIFICAR 3    /* codificar */
+#define ETAPA_DECODIFICAR 4  /* leer el arbol, armar la tabla de decodificacion y decodificar */
+#define NUM_ETAPAS 5
+
+/* benchmark_ejecutar mide la cola de prioridades con 256, 64K y 1M elementos */
+#define NUM_TAMANOS_PQ 3
+
+/* capacidad de la cola original (sin agrandar), el unico tamano que se puede comparar */
+#define BENCHMARK_PQ_ORIGINAL 256
+
+typedef struct _OpcionesBenchmark {
+	size_t tam_sintetico;  /* bytes de cada corpus sintetico, 0 = solo los archivos */
+	int repeticiones;      /* veces que se repite cada medicion, se reporta la mejor */
+	int formato;           /* BENCHMARK_JSON o BENCHMARK_CSV */
+} OpcionesBenchmark;
+
+/* Una medicion: el mejor tiempo de las repeticiones */
+typedef struct _MedicionBenchmark {
+	double segundos;
+	unsigned long long ciclos;  /* ciclos de esa repeticion, 0 si no se pueden contar */
+} MedicionBenchmark;
+
+/* Llena op con 1 MiB por corpus sintetico, 5 repeticiones y salida JSON */
+void benchmark_opciones_defecto(OpcionesBenchmark* op);
+
+/* retorna el nombre del corpus sintetico tipo, NULL si no existe */
+const char* benchmark_nombre_corpus(int tipo);
+
+/* Llena los n bytes de datos con el corpus sintetico tipo (siempre los mismos bytes)
+retorna 0 si no hay errores */
+int benchmark_corpus(int tipo, unsigned char* datos, size_t n);
+
+/*
+  Corre el benchmark sobre los corpus sinteticos y los num archivos,
+  escribiendo los resultados en out (op NULL = benchmark_opciones_defecto).
+  retorna 0 si todas las mediciones terminaron bien (las ida y vuelta
+  devuelven los mismos datos), 1 si alguna fallo
+*/
+int benchmark_ejecutar(char** archivos, int num, const OpcionesBenchmark* op, FILE* out);
+
+/*
+  Mide la cola de prioridades (pq.c) con n prioridades al azar (siempre las
+  mismas): n pq_add seguidos de n pq_remove, y un pq_heapify de los mismos
+  elementos. Escribe una linea por operacion en out, con corpus "pq", variante
+  "aridad" + PQ_ARIDAD y la cantidad de elementos en bytes, asi se pueden
+  comparar programas compilados con distinta aridad (op NULL = benchmark_opciones_defecto).
+  Con n <= BENCHMARK_PQ_ORIGINAL tambien se mide la cola original (un malloc
+  por PrioValue, binaria, de capacidad fija) como variante "original".
+  retorna 0 si no hay errores (y los pq_remove salen en orden)
+*/
+int benchmark_pq(int n, const OpcionesBenchmark* op, FILE* out);
+
+/* retorna un reloj monotono en segundos */
+double benchmark_reloj(void);
+
+/* retorna el tiempo de CPU del hilo que llama en segundos */
+double benchmark_reloj_cpu(void);
+
+/* retorna el contador de ciclos del procesador, 0 si no hay uno (solo x86) */
+unsigned long long benchmark_ciclos(void);
+
+/*
+  Mide por separado las etapas internas del compresor de dos pasadas en MODO_ARBOL
+  sobre los n bytes de datos. Esta en huffman.c porque las etapas son privadas.
+  etapas[ETAPA_x] queda con el mejor tiempo de repeticiones vueltas
+  retorna 0 si no hay errores (y la decodificacion devuelve los datos)
+*/
+int huffman_medir_etapas(const unsigned char* datos, size_t n, int repeticiones, MedicionBenchmark* etapas);
+
+#endif
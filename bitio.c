@@ -0,0 +1,342 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "bitio.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void _vaciar_buffer(BitWriter bw);
+static int _llenar_buffer(BitReader br);
+
+/* Abre el archivo para escritura
+retorna NULL si hubo error */
+BitWriter OpenBitWriter(char* nombre) {
+	if (nombre == NULL) return NULL;
+
+	// crear el escritor y su buffer
+	BitWriter bw = (BitWriter)malloc(sizeof(struct _BitWriter));
+	if (bw == NULL) return NULL;
+	bw->buf = malloc(BITIO_BUFFER_SALIDA);
+	if (bw->buf == NULL) {
+		free(bw);
+		return NULL;
+	}
+	bw->f = fopen(nombre, "wb");
+	if (bw->f == NULL) {
+		perror("Error al abrir el archivo");
+		free(bw->buf);
+		free(bw);
+		return NULL;
+	}
+	// el buffer del escritor ya es grande, el de stdio solo agregaria una copia
+	setvbuf(bw->f, NULL, _IONBF, 0);
+	bw->acc = 0;
+	bw->n = 0;
+	bw->pos = 0;
+	bw->cap = BITIO_BUFFER_SALIDA;
+	bw->error = 0;
+	bw->propio = 1;
+	return bw;
+}
+
+/* Crea un escritor que escribe en buf (de cap bytes), sin archivo
+retorna NULL si hubo error */
+BitWriter OpenBitWriterMem(unsigned char* buf, size_t cap) {
+	if (buf == NULL) return NULL;
+	BitWriter bw = (BitWriter)malloc(sizeof(struct _BitWriter));
+	if (bw == NULL) return NULL;
+	InitBitWriterMem(bw, buf, cap);
+	return bw;
+}
+
+/* Como OpenBitWriterMem pero sobre un struct _BitWriter del llamador, sin pedir memoria */
+void InitBitWriterMem(BitWriter bw, unsigned char* buf, size_t cap) {
+	bw->f = NULL;
+	bw->buf = buf;
+	bw->acc = 0;
+	bw->n = 0;
+	bw->pos = 0;
+	bw->cap = buf != NULL ? cap : 0;
+	bw->error = buf == NULL;
+	bw->propio = 0;
+}
+
+/*
+  Agrega los n bits menos significativos de bits.
+  Mientras entren en el acumulador solo se hace un shift y un OR,
+  cuando se completan 64 bits se pasa la palabra entera al buffer.
+*/
+void PutBits(BitWriter bw, unsigned long long bits, int n) {
+	if (bw->n + n < 64) {
+		bw->acc |= bits << bw->n;
+		bw->n += n;
+		return;
+	}
+
+	// completar la palabra y pasarla al buffer (little endian)
+	int usados = 64 - bw->n;
+	unsigned long long palabra = bw->n < 64 ? bw->acc | (bits << bw->n) : bw->acc;
+	if (bw->pos + 8 > bw->cap) _vaciar_buffer(bw);
+	if (bw->pos + 8 <= bw->cap) {
+		unsigned char* p = bw->buf + bw->pos;
+		for (int i = 0; i < 8; i++) {
+			p[i] = (unsigned char)(palabra >> (8 * i));
+		}
+		bw->pos += 8;
+	}
+	else { // escritor de memoria lleno
+		bw->error = 1;
+	}
+
+	// lo que no entro queda en el acumulador
+	bw->acc = usados < 64 ? bits >> usados : 0;
+	bw->n = n - usados;
+}
+
+/* Completa el ultimo byte con 0s, escribe todo lo pendiente y cierra el archivo
+retorna 0 si no hubo errores */
+int CloseBitWriter(BitWriter bw) {
+	if (bw == NULL) return 1;
+
+	// pasar los bytes que quedan en el acumulador
+	while (bw->n > 0) {
+		if (bw->pos == bw->cap) _vaciar_buffer(bw);
+		bw->buf[bw->pos++] = (unsigned char)bw->acc;
+		bw->acc >>= 8;
+		bw->n -= 8;
+	}
+	_vaciar_buffer(bw);
+
+	int error = bw->error;
+	if (fclose(bw->f) != 0) error = 1;
+	free(bw->buf);
+	free(bw);
+	return error;
+}
+
+/* Completa el ultimo byte con 0s y libera el escritor de memoria
+retorna la cantidad de bytes escritos en buf, -1 si no entraron */
+long long CloseBitWriterMem(BitWriter bw) {
+	if (bw == NULL) return -1;
+	long long escritos = FlushBitWriterMem(bw);
+	free(bw);
+	return escritos;
+}
+
+/* Completa el ultimo byte con 0s sin liberar el escritor
+retorna la cantidad de bytes escritos en buf, -1 si no entraron */
+long long FlushBitWriterMem(BitWriter bw) {
+	while (bw->n > 0) {
+		if (bw->pos == bw->cap) {
+			bw->error = 1;
+			break;
+		}
+		bw->buf[bw->pos++] = (unsigned char)bw->acc;
+		bw->acc >>= 8;
+		bw->n -= 8;
+	}
+	bw->acc = 0;
+	bw->n = 0;
+	return bw->error ? -1 : (long long)bw->pos;
+}
+
+/* Abre el archivo para lectura
+retorna NULL si hubo error */
+BitReader OpenBitReader(char* nombre) {
+	if (nombre == NULL) return NULL;
+
+	BitReader br = (BitReader)malloc(sizeof(struct _BitReader));
+	if (br == NULL) return NULL;
+	br->buf = malloc(BITIO_BUFFER);
+	if (br->buf == NULL) {
+		free(br);
+		return NULL;
+	}
+	br->f = fopen(nombre, "rb");
+	if (br->f == NULL) {
+		perror("Error al abrir el archivo");
+		free(br->buf);
+		free(br);
+		return NULL;
+	}
+	br->acc = 0;
+	br->n = 0;
+	br->pos = 0;
+	br->tam = 0;
+	br->cap = BITIO_BUFFER;
+	br->cerrar = 1;
+	return br;
+}
+
+/* Crea un lector sobre un archivo ya abierto (por ejemplo stdin), no lo cierra al terminar
+retorna NULL si hubo error */
+BitReader OpenBitReaderStream(FILE* f) {
+	if (f == NULL) return NULL;
+	BitReader br = (BitReader)malloc(sizeof(struct _BitReader));
+	if (br == NULL) return NULL;
+	br->buf = malloc(BITIO_BUFFER);
+	if (br->buf == NULL) {
+		free(br);
+		return NULL;
+	}
+	br->f = f;
+	br->acc = 0;
+	br->n = 0;
+	br->pos = 0;
+	br->tam = 0;
+	br->cap = BITIO_BUFFER;
+	br->cerrar = 0;
+	return br;
+}
+
+/* Crea un lector sobre los tam bytes de datos, sin copiarlos
+retorna NULL si hubo error */
+BitReader OpenBitReaderMem(const unsigned char* datos, size_t tam) {
+	if (datos == NULL && tam > 0) return NULL;
+	BitReader br = (BitReader)malloc(sizeof(struct _BitReader));
+	if (br == NULL) return NULL;
+	InitBitReaderMem(br, datos, tam);
+	return br;
+}
+
+/* Como OpenBitReaderMem pero sobre un struct _BitReader del llamador, sin pedir memoria */
+void InitBitReaderMem(BitReader br, const unsigned char* datos, size_t tam) {
+	// el buffer es el bloque de memoria, ya esta lleno y no se libera
+	br->f = NULL;
+	br->buf = (unsigned char*)datos;
+	br->acc = 0;
+	br->n = 0;
+	br->pos = 0;
+	br->tam = datos != NULL ? tam : 0;
+	br->cap = br->tam;
+	br->cerrar = 0;
+}
+
+/* Llena el acumulador hasta tener al menos 57 bits, o todos los que quedan en el archivo
+retorna la cantidad de bits disponibles */
+int FillBits(BitReader br) {
+	if (br->n > 56) return br->n;
+
+	// si hay 8 bytes en el buffer se carga una palabra entera,
+	// los bits que sobran por encima de n son los mismos que se vuelven a cargar despues
+	if (br->pos + 8 <= br->tam) {
+		unsigned long long palabra = BITIO_LEER64(br->buf + br->pos);
+		br->acc |= palabra << br->n;
+		int bytes = (63 - br->n) >> 3;
+		br->pos += bytes;
+		br->n += bytes * 8;
+		return br->n;
+	}
+
+	// cerca del final del buffer se carga byte por byte
+	while (br->n <= 56) {
+		if (br->pos == br->tam && !_llenar_buffer(br)) break;
+		br->acc |= (unsigned long long)br->buf[br->pos++] << br->n;
+		br->n += 8;
+	}
+	return br->n;
+}
+
+/* Lee y consume n bits (0 <= n <= 57)
+Si no hay suficientes bits, los que faltan se leen como 0 */
+unsigned long long GetBits(BitReader br, int n) {
+	if (n == 0) return 0;
+	if (br->n < n) FillBits(br);
+	unsigned long long bits = br->acc & (~0ULL >> (64 - n));
+	if (br->n < n) { // final del archivo
+		bits &= br->n > 0 ? ~0ULL >> (64 - br->n) : 0;
+		br->acc = 0;
+		br->n = 0;
+		return bits;
+	}
+	br->acc >>= n;
+	br->n -= n;
+	return bits;
+}
+
+/* Descarta los bits que faltan para completar el byte actual y copia los siguientes n bytes a dst
+retorna la cantidad de bytes copiados (menos de n si se termino el archivo) */
+size_t GetBytes(BitReader br, unsigned char* dst, size_t n) {
+	size_t copiados = 0;
+
+	// alinear al byte y vaciar primero los bytes que ya estan en el acumulador
+	br->acc >>= br->n & 7;
+	br->n -= br->n & 7;
+	while (br->n > 0 && copiados < n) {
+		dst[copiados++] = (unsigned char)br->acc;
+		br->acc >>= 8;
+		br->n -= 8;
+	}
+	if (br->n == 0) br->acc = 0;
+
+	// despues lo que queda en el buffer y por ultimo directo del archivo
+	while (copiados < n) {
+		if (br->pos == br->tam) {
+			if (br->f != NULL && n - copiados >= br->cap) {
+				size_t leidos = fread(dst + copiados, 1, n - copiados, br->f);
+				copiados += leidos;
+				if (leidos == 0) break;
+				continue;
+			}
+			if (!_llenar_buffer(br)) break;
+		}
+		size_t tam = br->tam - br->pos;
+		if (tam > n - copiados) tam = n - copiados;
+		memcpy(dst + copiados, br->buf + br->pos, tam);
+		br->pos += tam;
+		copiados += tam;
+	}
+	return copiados;
+}
+
+/* Como GetBytes pero sin copiar, solo para lectores de memoria
+retorna un puntero a los siguientes n bytes, NULL si no es de memoria o no quedan n bytes */
+const unsigned char* GetBytesMem(BitReader br, size_t n) {
+	if (br->f != NULL) return NULL;
+
+	// en memoria los bytes enteros del acumulador son los ultimos que se cargaron del buffer
+	br->acc >>= br->n & 7;
+	br->n -= br->n & 7;
+	size_t inicio = br->pos - (size_t)(br->n / 8);
+	if (n > br->tam - inicio) return NULL;
+	br->acc = 0;
+	br->n = 0;
+	br->pos = inicio + n;
+	return br->buf + inicio;
+}
+
+/* retorna 1 si ya no quedan bits por leer, 0 si quedan */
+int IsEmptyBitReader(BitReader br) {
+	if (br->n > 0) return 0;
+	return FillBits(br) == 0;
+}
+
+/* Cierra el archivo y libera el lector */
+void CloseBitReader(BitReader br) {
+	if (br == NULL) return;
+	if (br->f == NULL) { // lector de memoria, los datos son del llamador
+		free(br);
+		return;
+	}
+	if (br->cerrar) fclose(br->f);
+	free(br->buf);
+	free(br);
+}
+
+// FUNCIONES ADICIONALES -----------
+
+/* Escribe el contenido del buffer al archivo (en memoria no hay nada que hacer) */
+static void _vaciar_buffer(BitWriter bw) {
+	if (bw->f == NULL) return;
+	if (bw->pos > 0 && fwrite(bw->buf, 1, bw->pos, bw->f) != bw->pos) {
+		bw->error = 1;
+	}
+	bw->pos = 0;
+}
+
+/* Lee el siguiente bloque del archivo al buffer,
+retorna 0 si ya no hay mas datos */
+static int _llenar_buffer(BitReader br) {
+	if (br->f == NULL) return 0; // en memoria no hay mas datos
+	br->tam = fread(br->buf, 1, br->cap, br->f);
+	br->pos = 0;
+	return br->tam > 0;
+}
@@ -0,0 +1,129 @@
+#ifndef DEFINE_BITIO_H
+#define DEFINE_BITIO_H
+
+#include <stdio.h>
+
+/*Definicion del API de lectura/escritura de bits por palabras, la implementacion va en bitio.c*/
+
+/*
+  Extension de BitStream (ver PutBit/PutByte/GetBit/GetByte de bitstream.h)
+  que trabaja con varios bits a la vez.
+  Los bits se juntan en un acumulador de 64 bits y se escriben/leen al
+  archivo por palabras completas a traves de un buffer.
+
+  Orden de los bits: el primer bit del flujo es el bit 0 del primer byte,
+  igual que campobits guarda el primer bit del codigo en la posicion 0.
+  Asi un codigo de campobits se agrega con un solo shift y OR.
+*/
+
+/* tamano del buffer de lectura */
+#define BITIO_BUFFER (1 << 16)
+
+/* tamano del buffer de escritura a archivo: se escribe de a bloques grandes
+sin el buffer de stdio (cada vaciado es una sola llamada a write) */
+#define BITIO_BUFFER_SALIDA (1 << 20)
+
+/* Lee 8 bytes de p como un entero little endian.
+Escrito como una sola expresion para que el compilador lo convierta en una sola carga
+(con un ciclo de 8 iteraciones gcc carga byte por byte) */
+#define BITIO_LEER64(p) \
+	((unsigned long long)(p)[0] | (unsigned long long)(p)[1] << 8 | \
+	(unsigned long long)(p)[2] << 16 | (unsigned long long)(p)[3] << 24 | \
+	(unsigned long long)(p)[4] << 32 | (unsigned long long)(p)[5] << 40 | \
+	(unsigned long long)(p)[6] << 48 | (unsigned long long)(p)[7] << 56)
+
+/* BitWriter: acumulador de bits + buffer de salida
+si f es NULL escribe directamente en un bloque de memoria del llamador */
+typedef struct _BitWriter {
+	FILE* f;
+	unsigned long long acc; /* bits pendientes, el primero en la posicion 0 */
+	int n;                  /* cantidad de bits en acc */
+	unsigned char* buf;
+	size_t pos;
+	size_t cap;
+	int error;
+	int propio;             /* el buffer y el archivo son del escritor */
+}*BitWriter;
+
+/* BitReader: buffer de entrada + acumulador de bits
+si f es NULL lee de un bloque de memoria del llamador */
+typedef struct _BitReader {
+	FILE* f;
+	unsigned long long acc; /* bits leidos y no consumidos, el siguiente en la posicion 0 */
+	int n;                  /* cantidad de bits validos en acc */
+	unsigned char* buf;
+	size_t pos;
+	size_t tam;
+	size_t cap;
+	int cerrar;             /* cerrar f al destruir el lector */
+}*BitReader;
+
+/* Abre el archivo para escritura
+retorna NULL si hubo error */
+BitWriter OpenBitWriter(char* nombre);
+
+/*
+  Agrega los n bits menos significativos de bits (0 <= n <= 64),
+  el bit 0 es el primero en escribirse. Los bits por encima de n deben ser 0.
+*/
+void PutBits(BitWriter bw, unsigned long long bits, int n);
+
+/* Completa el ultimo byte con 0s, escribe todo lo pendiente y cierra el archivo
+retorna 0 si no hubo errores */
+int CloseBitWriter(BitWriter bw);
+
+/* Crea un escritor que escribe en buf (de cap bytes), sin archivo
+retorna NULL si hubo error */
+BitWriter OpenBitWriterMem(unsigned char* buf, size_t cap);
+
+/* Completa el ultimo byte con 0s y libera el escritor de memoria
+retorna la cantidad de bytes escritos en buf, -1 si no entraron */
+long long CloseBitWriterMem(BitWriter bw);
+
+/* Como OpenBitWriterMem pero sobre un struct _BitWriter del llamador (por ejemplo en el stack),
+sin pedir memoria. Se termina con FlushBitWriterMem */
+void InitBitWriterMem(BitWriter bw, unsigned char* buf, size_t cap);
+
+/* Completa el ultimo byte con 0s sin liberar el escritor
+retorna la cantidad de bytes escritos en buf, -1 si no entraron */
+long long FlushBitWriterMem(BitWriter bw);
+
+/* Abre el archivo para lectura
+retorna NULL si hubo error */
+BitReader OpenBitReader(char* nombre);
+
+/* Crea un lector sobre un archivo ya abierto (por ejemplo stdin), no lo cierra al terminar
+retorna NULL si hubo error */
+BitReader OpenBitReaderStream(FILE* f);
+
+/* Crea un lector sobre los tam bytes de datos, sin copiarlos
+retorna NULL si hubo error */
+BitReader OpenBitReaderMem(const unsigned char* datos, size_t tam);
+
+/* Como OpenBitReaderMem pero sobre un struct _BitReader del llamador, sin pedir memoria
+(no hace falta cerrarlo) */
+void InitBitReaderMem(BitReader br, const unsigned char* datos, size_t tam);
+
+/* Llena el acumulador hasta tener al menos 57 bits, o todos los que quedan en el archivo
+retorna la cantidad de bits disponibles */
+int FillBits(BitReader br);
+
+/* Lee y consume n bits (0 <= n <= 57)
+Si no hay suficientes bits, los que faltan se leen como 0 */
+unsigned long long GetBits(BitReader br, int n);
+
+/* Descarta los bits que faltan para completar el byte actual y copia los siguientes n bytes a dst
+retorna la cantidad de bytes copiados (menos de n si se termino el archivo) */
+size_t GetBytes(BitReader br, unsigned char* dst, size_t n);
+
+/* Como GetBytes pero sin copiar, solo para lectores de memoria
+retorna un puntero a los siguientes n bytes, NULL si no es de memoria o no quedan n bytes */
+const unsigned char* GetBytesMem(BitReader br, size_t n);
+
+/* retorna 1 si ya no quedan bits por leer, 0 si quedan */
+int IsEmptyBitReader(BitReader br);
+
+/* Cierra el archivo y libera el lector */
+void CloseBitReader(BitReader br);
+
+#endif
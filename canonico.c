@@ -0,0 +1,118 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "canonico.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void _escribir_gamma(BitWriter bw, unsigned int v);
+static unsigned int _leer_gamma(BitReader br);
+
+/*
+  Asigna los codigos canonicos a partir de las longitudes.
+  retorna 0 si no hay errores
+*/
+int canonico_codigos(const unsigned char* longitudes, int num_simbolos, unsigned int* codigos) {
+	unsigned int cuenta[CANONICO_MAX_LONGITUD + 1] = { 0 };
+	unsigned long long siguiente[CANONICO_MAX_LONGITUD + 1] = { 0 };
+	if (longitudes == NULL || codigos == NULL) return 1;
+
+	// contar cuantos codigos hay de cada longitud
+	for (int s = 0; s < num_simbolos; s++) {
+		if (longitudes[s] > CANONICO_MAX_LONGITUD) return 1;
+		cuenta[longitudes[s]]++;
+	}
+	cuenta[0] = 0;
+
+	// primer codigo de cada longitud, verificando que no sobren codigos (desigualdad de Kraft)
+	unsigned long long codigo = 0;
+	for (int l = 1; l <= CANONICO_MAX_LONGITUD; l++) {
+		codigo = (codigo + cuenta[l - 1]) << 1;
+		siguiente[l] = codigo;
+		if (codigo + cuenta[l] > (1ULL << l)) return 1;
+	}
+
+	// los codigos se calculan con el bit mas significativo primero,
+	// se invierten para que el primer bit quede en la posicion 0
+	for (int s = 0; s < num_simbolos; s++) {
+		int l = longitudes[s];
+		codigos[s] = 0;
+		if (l == 0) continue;
+		unsigned long long c = siguiente[l]++;
+		unsigned int inv = 0;
+		for (int i = 0; i < l; i++) {
+			inv = (inv << 1) | (unsigned int)((c >> i) & 1);
+		}
+		codigos[s] = inv;
+	}
+	return 0;
+}
+
+/* Escribe las longitudes en forma compacta */
+void canonico_escribir(BitWriter bw, const unsigned char* longitudes, int num_simbolos) {
+	int usados = 0;
+	int max = 0;
+	for (int s = 0; s < num_simbolos; s++) {
+		if (longitudes[s] == 0) continue;
+		usados++;
+		if (longitudes[s] > max) max = longitudes[s];
+	}
+
+	// ancho necesario para guardar longitud - 1
+	int ancho = 1;
+	while ((1 << ancho) < max) ancho++;
+
+	_escribir_gamma(bw, (unsigned int)usados + 1);
+	PutBits(bw, (unsigned long long)(ancho - 1), 3);
+	int anterior = -1;
+	for (int s = 0; s < num_simbolos; s++) {
+		if (longitudes[s] == 0) continue;
+		_escribir_gamma(bw, (unsigned int)(s - anterior));
+		PutBits(bw, (unsigned long long)(longitudes[s] - 1), ancho);
+		anterior = s;
+	}
+}
+
+/* Lee las longitudes escritas con canonico_escribir
+retorna 0 si no hay errores */
+int canonico_leer(BitReader br, unsigned char* longitudes, int num_simbolos) {
+	memset(longitudes, 0, num_simbolos);
+
+	unsigned int usados = _leer_gamma(br);
+	if (usados == 0 || usados - 1 > (unsigned int)num_simbolos) return 1;
+	usados--;
+	int ancho = (int)GetBits(br, 3) + 1;
+
+	int s = -1;
+	for (unsigned int i = 0; i < usados; i++) {
+		unsigned int distancia = _leer_gamma(br);
+		if (distancia == 0 || s + (long long)distancia >= num_simbolos) return 1;
+		s += (int)distancia;
+		longitudes[s] = (unsigned char)(GetBits(br, ancho) + 1);
+		if (longitudes[s] > CANONICO_MAX_LONGITUD) return 1;
+	}
+	return 0;
+}
+
+// FUNCIONES ADICIONALES -----------
+
+/* Codigo gamma de Elias de v >= 1: tantos 0 como bits tiene v menos uno, y luego v desde su bit mas significativo */
+static void _escribir_gamma(BitWriter bw, unsigned int v) {
+	int nbits = 0;
+	while ((v >> nbits) > 1) nbits++;
+	PutBits(bw, 0, nbits);
+	for (int i = nbits; i >= 0; i--) {
+		PutBits(bw, (v >> i) & 1, 1);
+	}
+}
+
+/* Lee un codigo gamma de Elias, retorna 0 si es invalido */
+static unsigned int _leer_gamma(BitReader br) {
+	int nbits = 0;
+	while (GetBits(br, 1) == 0) {
+		if (++nbits > 31 || IsEmptyBitReader(br)) return 0;
+	}
+	unsigned int v = 1;
+	for (int i = 0; i < nbits; i++) {
+		v = (v << 1) | (unsigned int)GetBits(br, 1);
+	}
+	return v;
+}
@@ -0,0 +1,39 @@
+#ifndef DEFINE_CANONICO_H
+#define DEFINE_CANONICO_H
+
+#include "bitio.h"
+
+/*Definicion del API de codigos de Huffman canonicos, la implementacion va en canonico.c*/
+
+/*
+  En un codigo canonico solo importa la longitud del codigo de cada simbolo:
+  los codigos se asignan en orden de (longitud, simbolo), cada uno es el
+  anterior + 1 (corrido a la izquierda cuando aumenta la longitud).
+  Asi el compresor y el descompresor derivan los mismos codigos guardando
+  en la cabecera solo las longitudes.
+*/
+
+/* longitud maxima de un codigo, lo que entra en el unsigned int de campobits */
+#define CANONICO_MAX_LONGITUD 32
+
+/*
+  Asigna los codigos canonicos a partir de las longitudes.
+  codigos[s] queda con el primer bit del codigo en la posicion 0 (como campobits)
+  longitudes[s] == 0 significa que el simbolo no se usa
+  retorna 0 si no hay errores, 1 si las longitudes no forman un codigo de prefijo
+*/
+int canonico_codigos(const unsigned char* longitudes, int num_simbolos, unsigned int* codigos);
+
+/*
+  Escribe las longitudes en forma compacta:
+    cantidad de simbolos usados + 1 (gamma de Elias)
+    ancho en bits de cada longitud - 1 (3 bits)
+    por cada simbolo usado, en orden: distancia al anterior (gamma de Elias) y longitud - 1
+*/
+void canonico_escribir(BitWriter bw, const unsigned char* longitudes, int num_simbolos);
+
+/* Lee las longitudes escritas con canonico_escribir
+retorna 0 si no hay errores */
+int canonico_leer(BitReader br, unsigned char* longitudes, int num_simbolos);
+
+#endif
@@ -0,0 +1,325 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "hilos.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE hilo_t;
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+#define mutex_iniciar(m) InitializeCriticalSection(m)
+#define mutex_destruir(m) DeleteCriticalSection(m)
+#define mutex_tomar(m) EnterCriticalSection(m)
+#define mutex_soltar(m) LeaveCriticalSection(m)
+#define cond_iniciar(c) InitializeConditionVariable(c)
+#define cond_destruir(c) ((void)(c))
+#define cond_esperar(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define cond_despertar(c) WakeAllConditionVariable(c)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t hilo_t;
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+#define mutex_iniciar(m) pthread_mutex_init(m, NULL)
+#define mutex_destruir(m) pthread_mutex_destroy(m)
+#define mutex_tomar(m) pthread_mutex_lock(m)
+#define mutex_soltar(m) pthread_mutex_unlock(m)
+#define cond_iniciar(c) pthread_cond_init(c, NULL)
+#define cond_destruir(c) pthread_cond_destroy(c)
+#define cond_esperar(c, m) pthread_cond_wait(c, m)
+#define cond_despertar(c) pthread_cond_broadcast(c)
+#endif
+
+/*
+  Estado del pool. Todo se protege con mutex.
+  Cada llamada a pool_ejecutar es una "ronda": se publica la tarea, los hilos
+  toman indices de siguiente hasta llegar a n, y el ultimo que termina avisa.
+*/
+struct _PoolHilos {
+	hilo_t* hilos;
+	int num_hilos;      /* hilos creados, sin contar al que llama */
+	mutex_t mutex;
+	cond_t hay_trabajo;
+	cond_t terminado;
+	TareaHilos tarea;
+	void* ctx;
+	int n;
+	int siguiente;      /* proximo indice sin asignar */
+	int pendientes;     /* tareas que todavia no terminaron */
+	unsigned int ronda; /* cambia en cada pool_ejecutar */
+	int salir;
+};
+
+/*
+  Estado de un ayudante, protegido con mutex. tarea es la tarea pendiente o
+  en curso (NULL si no hay); el hilo la pone en NULL al terminarla. Una sola
+  condicion avisa los dos cambios (tarea nueva o terminada, y salir).
+*/
+struct _AyudanteHilos {
+	hilo_t hilo;
+	mutex_t mutex;
+	cond_t cambio;
+	TareaHilos tarea;
+	void* ctx;
+	int i;
+	int salir;
+};
+
+static void _trabajar(PoolHilos p);
+#ifdef _WIN32
+static DWORD WINAPI _hilo(LPVOID arg);
+static DWORD WINAPI _hilo_ayudante(LPVOID arg);
+#else
+static void* _hilo(void* arg);
+static void* _hilo_ayudante(void* arg);
+#endif
+
+/* retorna la cantidad de procesadores disponibles (al menos 1) */
+int hilos_disponibles(void) {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+#endif
+}
+
+/* Crea un pool de num_hilos hilos
+retorna NULL si hubo error */
+PoolHilos pool_crear(int num_hilos) {
+	if (num_hilos <= 0) num_hilos = hilos_disponibles();
+
+	PoolHilos p = (PoolHilos)malloc(sizeof(struct _PoolHilos));
+	if (p == NULL) return NULL;
+	p->hilos = NULL;
+	p->num_hilos = 0;
+	p->tarea = NULL;
+	p->ctx = NULL;
+	p->n = 0;
+	p->siguiente = 0;
+	p->pendientes = 0;
+	p->ronda = 0;
+	p->salir = 0;
+	mutex_iniciar(&p->mutex);
+	cond_iniciar(&p->hay_trabajo);
+	cond_iniciar(&p->terminado);
+
+	// el que llama a pool_ejecutar es uno de los hilos
+	if (num_hilos > 1) {
+		p->hilos = (hilo_t*)malloc(sizeof(hilo_t) * (num_hilos - 1));
+		if (p->hilos == NULL) {
+			pool_destruir(p);
+			return NULL;
+		}
+	}
+	for (int i = 0; i < num_hilos - 1; i++) {
+#ifdef _WIN32
+		p->hilos[i] = CreateThread(NULL, 0, _hilo, p, 0, NULL);
+		if (p->hilos[i] == NULL) break;
+#else
+		if (pthread_create(&p->hilos[i], NULL, _hilo, p) != 0) break;
+#endif
+		p->num_hilos++;
+	}
+	return p;
+}
+
+/* retorna la cantidad de hilos del pool */
+int pool_tamano(PoolHilos p) {
+	return p == NULL ? 1 : p->num_hilos + 1;
+}
+
+/* Ejecuta tarea(ctx, i) para i = 0..n-1 y espera a que terminen todas */
+void pool_ejecutar(PoolHilos p, TareaHilos tarea, void* ctx, int n) {
+	if (n <= 0) return;
+	if (p == NULL || p->num_hilos == 0) { // sin hilos, todo en el que llama
+		for (int i = 0; i < n; i++) tarea(ctx, i);
+		return;
+	}
+
+	mutex_tomar(&p->mutex);
+	p->tarea = tarea;
+	p->ctx = ctx;
+	p->n = n;
+	p->siguiente = 0;
+	p->pendientes = n;
+	p->ronda++;
+	cond_despertar(&p->hay_trabajo);
+	mutex_soltar(&p->mutex);
+
+	_trabajar(p);
+
+	mutex_tomar(&p->mutex);
+	while (p->pendientes > 0) {
+		cond_esperar(&p->terminado, &p->mutex);
+	}
+	mutex_soltar(&p->mutex);
+}
+
+/* Termina los hilos y libera el pool */
+void pool_destruir(PoolHilos p) {
+	if (p == NULL) return;
+	mutex_tomar(&p->mutex);
+	p->salir = 1;
+	cond_despertar(&p->hay_trabajo);
+	mutex_soltar(&p->mutex);
+
+	for (int i = 0; i < p->num_hilos; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(p->hilos[i], INFINITE);
+		CloseHandle(p->hilos[i]);
+#else
+		pthread_join(p->hilos[i], NULL);
+#endif
+	}
+	cond_destruir(&p->hay_trabajo);
+	cond_destruir(&p->terminado);
+	mutex_destruir(&p->mutex);
+	free(p->hilos);
+	free(p);
+}
+
+/* Crea un ayudante con su hilo
+retorna NULL si hubo error */
+AyudanteHilos ayudante_crear(void) {
+	AyudanteHilos a = (AyudanteHilos)malloc(sizeof(struct _AyudanteHilos));
+	if (a == NULL) return NULL;
+	a->tarea = NULL;
+	a->ctx = NULL;
+	a->i = 0;
+	a->salir = 0;
+	mutex_iniciar(&a->mutex);
+	cond_iniciar(&a->cambio);
+#ifdef _WIN32
+	a->hilo = CreateThread(NULL, 0, _hilo_ayudante, a, 0, NULL);
+	int error = a->hilo == NULL;
+#else
+	int error = pthread_create(&a->hilo, NULL, _hilo_ayudante, a) != 0;
+#endif
+	if (error) {
+		cond_destruir(&a->cambio);
+		mutex_destruir(&a->mutex);
+		free(a);
+		return NULL;
+	}
+	return a;
+}
+
+/* Ejecuta tarea(ctx, i) en el hilo del ayudante sin esperar a que termine */
+void ayudante_lanzar(AyudanteHilos a, TareaHilos tarea, void* ctx, int i) {
+	if (a == NULL) { // sin hilo, en el que llama
+		tarea(ctx, i);
+		return;
+	}
+	mutex_tomar(&a->mutex);
+	while (a->tarea != NULL) {
+		cond_esperar(&a->cambio, &a->mutex);
+	}
+	a->tarea = tarea;
+	a->ctx = ctx;
+	a->i = i;
+	cond_despertar(&a->cambio);
+	mutex_soltar(&a->mutex);
+}
+
+/* Espera a que termine la tarea lanzada, si hay una */
+void ayudante_esperar(AyudanteHilos a) {
+	if (a == NULL) return;
+	mutex_tomar(&a->mutex);
+	while (a->tarea != NULL) {
+		cond_esperar(&a->cambio, &a->mutex);
+	}
+	mutex_soltar(&a->mutex);
+}
+
+/* Espera la tarea, termina el hilo y libera el ayudante */
+void ayudante_destruir(AyudanteHilos a) {
+	if (a == NULL) return;
+	mutex_tomar(&a->mutex);
+	a->salir = 1;
+	cond_despertar(&a->cambio);
+	mutex_soltar(&a->mutex);
+#ifdef _WIN32
+	WaitForSingleObject(a->hilo, INFINITE);
+	CloseHandle(a->hilo);
+#else
+	pthread_join(a->hilo, NULL);
+#endif
+	cond_destruir(&a->cambio);
+	mutex_destruir(&a->mutex);
+	free(a);
+}
+
+// FUNCIONES ADICIONALES -----------
+
+/* Toma indices de la ronda actual hasta que no queden */
+static void _trabajar(PoolHilos p) {
+	mutex_tomar(&p->mutex);
+	while (p->siguiente < p->n) {
+		int i = p->siguiente++;
+		TareaHilos tarea = p->tarea;
+		void* ctx = p->ctx;
+		mutex_soltar(&p->mutex);
+
+		tarea(ctx, i);
+
+		mutex_tomar(&p->mutex);
+		if (--p->pendientes == 0) cond_despertar(&p->terminado);
+	}
+	mutex_soltar(&p->mutex);
+}
+
+/* Cuerpo de cada hilo: espera una ronda nueva y trabaja en ella */
+#ifdef _WIN32
+static DWORD WINAPI _hilo(LPVOID arg) {
+#else
+static void* _hilo(void* arg) {
+#endif
+	PoolHilos p = (PoolHilos)arg;
+	unsigned int ronda = 0;
+	mutex_tomar(&p->mutex);
+	while (1) {
+		while (!p->salir && p->ronda == ronda) {
+			cond_esperar(&p->hay_trabajo, &p->mutex);
+		}
+		if (p->salir) break;
+		ronda = p->ronda;
+		mutex_soltar(&p->mutex);
+		_trabajar(p);
+		mutex_tomar(&p->mutex);
+	}
+	mutex_soltar(&p->mutex);
+	return 0;
+}
+
+/* Cuerpo del hilo de un ayudante: ejecuta cada tarea que le lanzan.
+Al salir termina antes la que tenga pendiente */
+#ifdef _WIN32
+static DWORD WINAPI _hilo_ayudante(LPVOID arg) {
+#else
+static void* _hilo_ayudante(void* arg) {
+#endif
+	AyudanteHilos a = (AyudanteHilos)arg;
+	mutex_tomar(&a->mutex);
+	while (1) {
+		while (!a->salir && a->tarea == NULL) {
+			cond_esperar(&a->cambio, &a->mutex);
+		}
+		if (a->tarea == NULL) break;
+		TareaHilos tarea = a->tarea;
+		void* ctx = a->ctx;
+		int i = a->i;
+		mutex_soltar(&a->mutex);
+
+		tarea(ctx, i);
+
+		mutex_tomar(&a->mutex);
+		a->tarea = NULL;
+		cond_despertar(&a->cambio);
+	}
+	mutex_soltar(&a->mutex);
+	return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef DEFINE_HILOS_H
+#define DEFINE_HILOS_H
+
+/*Definicion del API del pool de hilos, la implementacion va en hilos.c*/
+
+/*
+  Un pool tiene un numero fijo de hilos que se crean una sola vez.
+  pool_ejecutar() reparte las tareas 0..n-1 entre los hilos (el hilo que llama
+  tambien trabaja) y retorna cuando terminaron todas.
+  Usa pthreads, o los hilos de Windows cuando se compila con _WIN32.
+*/
+
+/* una tarea recibe el contexto compartido y su indice */
+typedef void (*TareaHilos)(void* ctx, int i);
+
+typedef struct _PoolHilos* PoolHilos;
+
+/* retorna la cantidad de procesadores disponibles (al menos 1) */
+int hilos_disponibles(void);
+
+/* Crea un pool de num_hilos hilos (contando al que llama a pool_ejecutar)
+num_hilos <= 0 usa hilos_disponibles()
+retorna NULL si hubo error */
+PoolHilos pool_crear(int num_hilos);
+
+/* retorna la cantidad de hilos del pool */
+int pool_tamano(PoolHilos p);
+
+/* Ejecuta tarea(ctx, i) para i = 0..n-1 y espera a que terminen todas */
+void pool_ejecutar(PoolHilos p, TareaHilos tarea, void* ctx, int n);
+
+/* Termina los hilos y libera el pool */
+void pool_destruir(PoolHilos p);
+
+/*
+  Un ayudante es un hilo aparte para una tarea que se superpone con lo que
+  sigue haciendo el que llama (leer o escribir un archivo mientras el pool
+  codifica). Ejecuta de a una tarea: ayudante_lanzar no espera a que termine,
+  ayudante_esperar si. Con un ayudante NULL la tarea se ejecuta en el que
+  llama, dentro de ayudante_lanzar.
+*/
+typedef struct _AyudanteHilos* AyudanteHilos;
+
+/* Crea un ayudante con su hilo
+retorna NULL si hubo error */
+AyudanteHilos ayudante_crear(void);
+
+/* Ejecuta tarea(ctx, i) en el hilo del ayudante sin esperar a que termine
+(si todavia tiene una tarea, primero espera esa) */
+void ayudante_lanzar(AyudanteHilos a, TareaHilos tarea, void* ctx, int i);
+
+/* Espera a que termine la tarea lanzada, si hay una */
+void ayudante_esperar(AyudanteHilos a);
+
+/* Espera la tarea, termina el hilo y libera el ayudante */
+void ayudante_destruir(AyudanteHilos a);
+
+#endif
@@ -0,0 +1,97 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "histograma.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* bytes que se cuentan antes de pasar las tablas de 32 bits a los totales,
+cada tabla recibe a lo sumo HISTOGRAMA_TRAMO / HISTOGRAMA_TABLAS */
+#define HISTOGRAMA_TRAMO ((size_t)1 << 30)
+
+static void _contar_tramo(const unsigned char* datos, size_t n, unsigned long long* frecuencias);
+
+/* Suma a frecuencias[256] la cantidad de veces que aparece cada byte */
+void histograma_contar(const unsigned char* datos, size_t n, unsigned long long* frecuencias) {
+	if (datos == NULL || frecuencias == NULL) return;
+	while (n > 0) {
+		size_t tramo = n < HISTOGRAMA_TRAMO ? n : HISTOGRAMA_TRAMO;
+		_contar_tramo(datos, tramo, frecuencias);
+		datos += tramo;
+		n -= tramo;
+	}
+}
+
+/*
+  Suma a frecuencias[256 * 256] cada par (anterior, byte).
+  Con 64K contadores dos pares seguidos casi nunca caen en el mismo,
+  asi que no hacen falta las tablas intercaladas.
+*/
+void histograma_contar_contexto(const unsigned char* datos, size_t n, unsigned long long* frecuencias) {
+	if (datos == NULL || frecuencias == NULL) return;
+	unsigned int anterior = 0;
+	for (size_t i = 0; i < n; i++) {
+		frecuencias[(anterior << 8) | datos[i]]++;
+		anterior = datos[i];
+	}
+}
+
+/* Suma a frecuencias[65536] cada uno de los n simbolos de 16 bits */
+void histograma_contar16(const unsigned short* simbolos, size_t n, unsigned long long* frecuencias) {
+	if (simbolos == NULL || frecuencias == NULL) return;
+	for (size_t i = 0; i < n; i++) {
+		frecuencias[simbolos[i]]++;
+	}
+}
+
+/* Suma a frecuencias[256] los bytes de f
+retorna 0 si no hay errores */
+int histograma_archivo(FILE* f, unsigned long long* frecuencias) {
+	if (f == NULL || frecuencias == NULL) return 1;
+	unsigned char* buf = malloc(HISTOGRAMA_BUFFER);
+	if (buf == NULL) return 1;
+
+	size_t leidos = 0;
+	while ((leidos = fread(buf, 1, HISTOGRAMA_BUFFER, f)) > 0) {
+		histograma_contar(buf, leidos, frecuencias);
+	}
+
+	int error = ferror(f) ? 1 : 0;
+	free(buf);
+	return error;
+}
+
+// FUNCIONES ADICIONALES -----------
+
+/*
+  Cuenta un tramo en tablas de 32 bits y suma el resultado.
+  Se leen 8 bytes a la vez y cada uno va a una tabla distinta,
+  asi dos incrementos seguidos nunca tocan el mismo contador.
+*/
+static void _contar_tramo(const unsigned char* datos, size_t n, unsigned long long* frecuencias) {
+	unsigned int tablas[HISTOGRAMA_TABLAS][256];
+	memset(tablas, 0, sizeof(tablas));
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		unsigned long long w;
+		memcpy(&w, datos + i, 8); // el orden de los bytes no importa para contar
+		tablas[0 % HISTOGRAMA_TABLAS][w & 0xFF]++;
+		tablas[1 % HISTOGRAMA_TABLAS][(w >> 8) & 0xFF]++;
+		tablas[2 % HISTOGRAMA_TABLAS][(w >> 16) & 0xFF]++;
+		tablas[3 % HISTOGRAMA_TABLAS][(w >> 24) & 0xFF]++;
+		tablas[4 % HISTOGRAMA_TABLAS][(w >> 32) & 0xFF]++;
+		tablas[5 % HISTOGRAMA_TABLAS][(w >> 40) & 0xFF]++;
+		tablas[6 % HISTOGRAMA_TABLAS][(w >> 48) & 0xFF]++;
+		tablas[7 % HISTOGRAMA_TABLAS][w >> 56]++;
+	}
+	for (; i < n; i++) {
+		tablas[i % HISTOGRAMA_TABLAS][datos[i]]++;
+	}
+
+	for (int c = 0; c < 256; c++) {
+		unsigned long long total = 0;
+		for (int t = 0; t < HISTOGRAMA_TABLAS; t++) {
+			total += tablas[t][c];
+		}
+		frecuencias[c] += total;
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef DEFINE_HISTOGRAMA_H
+#define DEFINE_HISTOGRAMA_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*Definicion del API para contar frecuencias de bytes, la implementacion va en histograma.c*/
+
+/*
+  Con un solo arreglo de contadores, en datos repetitivos cada incremento
+  espera al anterior sobre el mismo contador (store -> load). Por eso se
+  cuenta en HISTOGRAMA_TABLAS arreglos intercalados (el byte i va a la
+  tabla i % HISTOGRAMA_TABLAS) que se suman al final.
+  Los conteos son de 64 bits, asi no se desbordan con archivos de mas de 2 GiB.
+  Se cuentan 8 bytes por vuelta, HISTOGRAMA_TABLAS tiene que ser 1, 2, 4 u 8.
+*/
+#ifndef HISTOGRAMA_TABLAS
+#define HISTOGRAMA_TABLAS 8
+#endif
+
+/* bytes que se leen del archivo de una vez */
+#define HISTOGRAMA_BUFFER (1 << 20)
+
+/* Suma a frecuencias[256] la cantidad de veces que aparece cada byte en los n bytes de datos */
+void histograma_contar(const unsigned char* datos, size_t n, unsigned long long* frecuencias);
+
+/*
+  Histograma de orden 1: suma a frecuencias[256 * 256] cuantas veces aparece
+  cada byte despues de cada otro, frecuencias[anterior * 256 + byte].
+  El primer byte cuenta como si el anterior fuera 0.
+*/
+void histograma_contar_contexto(const unsigned char* datos, size_t n, unsigned long long* frecuencias);
+
+/*
+  Suma a frecuencias[65536] la cantidad de veces que aparece cada uno de los
+  n simbolos de 16 bits. Se cuenta directo en frecuencias: con 64K contadores
+  las tablas intercaladas de histograma_contar no entran en cache.
+*/
+void histograma_contar16(const unsigned short* simbolos, size_t n, unsigned long long* frecuencias);
+
+/* Suma a frecuencias[256] los bytes de f, leyendo hasta el final
+retorna 0 si no hay errores */
+int histograma_archivo(FILE* f, unsigned long long* frecuencias);
+
+#endif
@@ -4,11 +4,31 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <math.h>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 #include "arbol.h"
 #include "pq.h"
 #include "bitstream.h"
+#include "bitio.h"
+#include "canonico.h"
+#include "huffman_opciones.h"
+#include "huffman_modelo.h"
+#include "huffman_contexto.h"
+#include "huffman_lector.h"
+#include "huffman_simbolos.h"
+#include "huffman_estadisticas.h"
+#include "benchmark.h"
 #include "confirm.h"
+#include "tabladec.h"
+#include "hilos.h"
+#include "histograma.h"
+#include "mapeo.h"
+#include "arena.h"
 
 /*====================================================
      Constantes
@@ -16,6 +36,277 @@
 
 #define NUM_CHARS 256
 
+/* en el byte de modo de MODO_ARBOL y MODO_CANONICO: despues del byte va la
+cantidad de caracteres originales (de a 7 bits por byte, como los mensajes de un modelo).
+Los archivos viejos no la tienen y se decodifican hasta que se terminan los bits */
+#define MODO_CON_CUENTA 0x80
+
+/* tipos de bloque en MODO_BLOQUES */
+#define BLOQUE_FIN 0
+#define BLOQUE_HUFFMAN 1
+#define BLOQUE_HUFFMAN4 2  /* los codigos van en 4 flujos intercalados */
+#define BLOQUE_CRUDO 3     /* el cuerpo son los bytes originales, sin codificar */
+#define BLOQUE_RLE 4       /* un solo caracter repetido n veces, el cuerpo es ese byte */
+#define BLOQUE_VALIDO(tipo) ((tipo) >= BLOQUE_HUFFMAN && (tipo) <= BLOQUE_RLE)
+
+/* el cuerpo de un BLOQUE_HUFFMAN4 empieza con el tamano de los 3 primeros flujos (4 bytes c/u) */
+#define SALTOS_FLUJOS 12
+
+/* cabecera de cada bloque: tipo (1 byte), tamano original y tamano comprimido (4 bytes c/u) */
+#define CABECERA_BLOQUE 9
+
+/* tamano maximo de bloque que se acepta al descomprimir */
+#define MAX_TAM_BLOQUE (1 << 28)
+
+/* bloques que se procesan juntos por cada hilo del pool */
+#define BLOQUES_POR_HILO 4
+
+/* tandas en vuelo en MODO_BLOQUES con archivos: una se lee, otra se codifica y otra se escribe */
+#define RANURAS_TUBERIA 3
+
+/* marca al final del indice de bloques ("HIDX" en little endian) */
+#define INDICE_MAGIA 0x58444948u
+
+/* bytes maximos del tamano de un mensaje codificado con un modelo (7 bits por byte) */
+#define MAX_TAM_VARIABLE 10
+
+/* bytes maximos de la cabecera de longitudes canonicas o del arbol en preorden */
+#define MAX_CABECERA 1024
+
+/* MODO_CONTEXTO: como mucho una tabla por contexto */
+#define MAX_TABLAS_CONTEXTO 256
+
+/* MODO_CONTEXTO: bits maximos de la tabla primaria de cada contexto (chicas, para que entren todas en cache) */
+#define BITS_CONTEXTO 8
+
+/* MODO_CONTEXTO: veces que se reparten los contextos entre la tabla comun y las propias */
+#define RONDAS_CONTEXTO 4
+
+/* MODO_CONTEXTO: memoria de trabajo de los constructores al repartir los contextos */
+#define TRABAJO_CONTEXTO (64 * 1024)
+
+/* MODO_SIMBOLOS16: bits maximos de la tabla primaria. Crece desde TABLADEC_BITS
+hasta tener una entrada por simbolo usado: con mas simbolos las subtablas ya ocupan
+lo mismo y asi cada codigo se resuelve con una sola busqueda */
+#define BITS_SIMBOLOS 16
+
+/* MODO_SIMBOLOS16: muestras que se arman o se pasan a bytes de una vez */
+#define TRAMO_MUESTRAS 4096
+
+/* MODO_SIMBOLOS16: bytes maximos de las longitudes de un alfabeto de num simbolos.
+Por simbolo usado la distancia al anterior (gamma, a lo sumo 2 bits por cada
+simbolo que salta) y la longitud (5 bits), mas la cantidad y el ancho */
+#define CABECERA_SIMBOLOS(num) (((size_t)(num) * 7 + 36 + 7) / 8)
+
+/*
+  Tabla de decodificacion armada con las ultimas longitudes canonicas leidas.
+  Si el siguiente bloque o mensaje trae las mismas longitudes se reusa sin
+  armarla de nuevo (ver tabla_cacheada). tabla es NULL si no hay ninguna.
+*/
+typedef struct _CacheTabla {
+    unsigned char longitudes[NUM_CHARS];
+    TablaDec tabla;
+} CacheTabla;
+
+/*
+  Tabla de decodificacion de un contexto de MODO_CONTEXTO: entradas y mascara
+  copiadas de tabla para no seguir el puntero en cada caracter. Un contexto
+  con un solo simbolo no tiene tabla (es NULL), su unica entrada no consume bits.
+*/
+typedef struct _ContextoDec {
+    const EntradaDec* entradas;
+    unsigned long long mascara;
+    TablaDec tabla;
+} ContextoDec;
+
+/* Las tablas de cada byte anterior, bmax es el codigo mas largo de todas.
+Si todos los contextos usan la misma tabla (de mas de un simbolo) unica es esa
+tabla, armada con TABLADEC_BITS, y se decodifica como MODO_CANONICO */
+typedef struct _TablasContexto {
+    ContextoDec ctx[NUM_CHARS];
+    int bmax;
+    TablaDec unica;
+} TablasContexto;
+
+/*
+  Un bloque de una tanda: lo que necesita un hilo para codificarlo o decodificarlo.
+  datos tiene n bytes originales, cuerpo tiene tam bytes codificados (cap como maximo).
+*/
+typedef struct _TrabajoBloque {
+    unsigned char* datos;
+    size_t n;
+    unsigned char* cuerpo;
+    size_t tam;
+    size_t cap;
+    int max_longitud;
+    int flujos;
+    int tipo;     /* BLOQUE_* del cuerpo: lo elige codificar_bloque, o viene en la cabecera al decodificar */
+    Arena arena;  /* memoria de trabajo, al codificar se vacia al empezar cada bloque */
+    CacheTabla cache;  /* al decodificar: la ultima tabla armada en este lugar, sale de arena */
+    int error;
+#ifndef HUFFMAN_SIN_ESTADISTICAS
+    EstadisticasHuffman est;  /* lo que se midio en el ultimo bloque de este lugar, en su hilo */
+#endif
+} TrabajoBloque;
+
+/*
+  Lo que comprimir_bloques y descomprimir_bloques necesitan para procesar tandas
+  en el pool: los hilos, un trabajo con su arena por cada lugar de la tanda, los
+  buffers de datos y cuerpos y el indice de bloques. Un contexto lo guarda entre
+  llamadas; si no, se arma y se libera en cada una (ver tanda_preparar).
+  Con archivos hay varias ranuras, cada una con su tanda de trabajos y su parte
+  de los buffers, y los hilos ayudantes que leen y escriben (ver tuberia_ejecutar).
+*/
+typedef struct _Tanda {
+    PoolHilos pool;
+    TrabajoBloque* trabajos;  /* num por ranura */
+    int num;                  /* bloques de una tanda */
+    int ranuras;
+    AyudanteHilos lector;     /* con mas de una ranura, NULL si no se pudieron crear */
+    AyudanteHilos escritor;
+    unsigned char* datos;
+    size_t cap_datos;
+    unsigned char* cuerpos;
+    size_t cap_cuerpos;
+    unsigned int* indice;
+    size_t cap_indice;  /* en bytes */
+} Tanda;
+
+/* Los contextos de huffman_contexto.h */
+struct _CompresorHuffman {
+    OpcionesHuffman op;
+    Arena arena;  /* memoria de trabajo sin pool, se vacia en cada llamada */
+    Tanda tanda;  /* MODO_BLOQUES con op.hilos != 1 */
+};
+
+struct _DescompresorHuffman {
+    int hilos;
+    Arena arena;       /* memoria de trabajo sin pool, la tabla en cache sale de aca */
+    CacheTabla cache;
+    Tanda tanda;       /* MODO_BLOQUES con hilos != 1 */
+};
+
+/* El lector de huffman_lector.h */
+struct _LectorHuffman {
+    Mapeo mapa;                  /* el archivo mapeado, NULL si se lee con f o son datos del llamador */
+    FILE* f;
+    const unsigned char* datos;  /* el archivo comprimido completo, NULL si se lee con f */
+    unsigned int num;            /* bloques */
+    unsigned long long* inicio;  /* num + 1: posicion original de cada bloque, inicio[num] es el total */
+    unsigned long long* pos;     /* num + 1: posicion de la cabecera de cada bloque en el archivo, pos[num] es el BLOQUE_FIN */
+    unsigned char* cuerpo;       /* con f: la cabecera y el cuerpo del bloque que se esta leyendo */
+    size_t cap_cuerpo;
+    unsigned char* bloque;       /* el ultimo bloque decodificado en los bordes de un rango */
+    size_t cap_bloque;
+    long long ultimo;            /* su numero, -1 si no hay */
+    Arena arena;                 /* la tabla en cache sale de aca */
+    CacheTabla cache;
+};
+
+/*
+  Destino de comprimir_bloques y descomprimir_bloques: un archivo, o si f es NULL
+  un bloque de memoria del llamador de cap bytes. pos es lo escrito hasta ahora.
+*/
+typedef struct _Salida {
+    FILE* f;
+    unsigned char* buf;
+    size_t pos;
+    size_t cap;
+} Salida;
+
+/*
+  Lo que comparten las etapas de comprimir_bloques y descomprimir_bloques: el
+  lector solo usa la entrada y el escritor solo la salida. Por cada ranura el
+  lector deja cuantos bloques leyo y si es la ultima tanda.
+*/
+typedef struct _Tuberia {
+    Tanda* t;
+    int ranuras;                 /* las que usa esta llamada */
+    size_t tam_bloque;
+    size_t cap;                  /* tamano maximo del cuerpo de un bloque */
+    FILE* f;                     /* al comprimir: la entrada, NULL si es memoria */
+    const unsigned char* entrada;
+    size_t tam_entrada;
+    size_t pos_entrada;
+    BitReader in;                /* al descomprimir */
+    const unsigned int* indice;  /* al descomprimir: el indice de bloques, NULL si no hay */
+    unsigned int num_indice;
+    unsigned int leidos;         /* bloques leidos hasta ahora */
+    size_t destino;              /* al descomprimir en memoria: donde va el proximo bloque */
+    Salida* out;
+    size_t num_bloques;          /* al comprimir: entradas del indice escritas */
+    int bloques[RANURAS_TUBERIA];
+    int fin[RANURAS_TUBERIA];
+    int error_lectura;
+    int error_escritura;
+} Tuberia;
+
+/*
+  Estadisticas (ver huffman_estadisticas.h). _est apunta a las de la llamada en
+  curso en este hilo, NULL si no se esta midiendo. Cada llamada publica las
+  empieza y las termina (EST_EMPEZAR/EST_TERMINAR); en el medio EST_ETAPA suma a
+  una etapa el tiempo desde la marca anterior y deja la marca en ese momento.
+  En un hilo del pool se mide en las del trabajo (EST_TRABAJO) y el que llama
+  las suma despues de la tanda (EST_SUMAR_TANDA).
+  Con HUFFMAN_SIN_ESTADISTICAS las macros no hacen nada (sizeof no evalua nada).
+*/
+#ifndef HUFFMAN_SIN_ESTADISTICAS
+#ifdef _MSC_VER
+#define _LOCAL_HILO __declspec(thread)
+#else
+#define _LOCAL_HILO __thread
+#endif
+
+typedef struct _Marca {
+    double pared;
+    double cpu;
+} Marca;
+
+static _LOCAL_HILO EstadisticasHuffman* _est = NULL;
+
+#define EST_EMPEZAR(e) EstadisticasHuffman e; EstadisticasHuffman* e##_afuera = _est_empezar(&e)
+#define EST_TERMINAR(e) _est_terminar(&e, e##_afuera)
+#define EST_TRABAJO(b) EstadisticasHuffman* _afuera = _est_trabajo(b)
+#define EST_FIN_TRABAJO(b) _est_fin_trabajo(b, _afuera)
+#define EST_SUMAR_TANDA(tanda, n) _est_sumar_tanda(tanda, n)
+#define EST_NUEVA_MARCA(m) Marca m = { 0, 0 }; _marcar(&m)
+#define EST_MARCAR(m) _marcar(&m)
+#define EST_ETAPA(etapa, m) _sumar_etapa(etapa, &m)
+#define EST_CONTAR(campo, v) do { if (_est != NULL) _est->campo += (v); } while (0)
+#define EST_MAXIMO(campo, v) do { if (_est != NULL && (v) > _est->campo) _est->campo = (v); } while (0)
+#else
+#define EST_EMPEZAR(e)
+#define EST_TERMINAR(e)
+#define EST_TRABAJO(b)
+#define EST_FIN_TRABAJO(b)
+#define EST_SUMAR_TANDA(tanda, n)
+#define EST_NUEVA_MARCA(m)
+#define EST_MARCAR(m)
+#define EST_ETAPA(etapa, m)
+#define EST_CONTAR(campo, v) ((void)sizeof(v))
+#define EST_MAXIMO(campo, v) ((void)sizeof(v))
+#endif
+
+/*
+  Arbol de huffman plano: todos los nodos en un solo arreglo contiguo, sin
+  punteros ni valores en el heap (2 KB para 256 caracteres). Los hijos son
+  indices dentro de nodos; en una hoja izq es HOJA y der es el caracter.
+  crear_huffman y leer_arbol lo llenan, crear_tabla y el resto lo recorren.
+*/
+#define MAX_NODOS (2 * NUM_CHARS - 1)
+#define HOJA (-1)
+
+typedef struct _NodoPlano {
+    short izq;
+    short der;
+} NodoPlano;
+
+typedef struct _ArbolPlano {
+    NodoPlano nodos[MAX_NODOS];
+    int num;   /* nodos usados */
+    int raiz;  /* -1 si el arbol esta vacio */
+} ArbolPlano;
+
 /*
 estructura para almacenar valores de un nodo de un arbol, 
 c es el caracter
@@ -68,7 +359,8 @@ static void bits_agregar(campobits* bits, int bit) {
     CONFIRM_RETURN((unsigned int)bits->tamano < 8*sizeof(bits->bits));
     bits->tamano++;
     if (bit) {
-        bits->bits = bits->bits | ( 0x1 << (bits->tamano-1));
+        // sin signo: con codigos de 32 bits el corrimiento llega al bit 31
+        bits->bits = bits->bits | ( 0x1u << (bits->tamano-1));
     } 
 }
 /*
@@ -82,9 +374,10 @@ static void bits_agregar(campobits* bits, int bit) {
 static int bits_leer(campobits* bits, int pos) {
     CONFIRM_TRUE(bits,0);
     CONFIRM_TRUE(!(pos < 0 || pos > bits->tamano),0);
+    CONFIRM_TRUE((unsigned int)pos < 8*sizeof(bits->bits),0);
     // para saber si campobits tiene un 1 o 0 en la posicion dada 
     // recorro bits usando shift << y >>
-    int bit = (bits->bits & (0x1 << (pos))) >> (pos);
+    int bit = (bits->bits & (0x1u << (pos))) >> (pos);
     return bit;
 }
 
@@ -189,21 +482,105 @@ void campobitsDemo() {
   ====================================================*/
 
 /* Puedes cambiar esto si quieres.. pero entiende bien lo que haces */
-static int calcular_frecuencias(int* frecuencias, char* entrada);
-static Arbol crear_huffman(int* frecuencias);
-static int codificar(Arbol T, char* entrada, char* salida);
-static void crear_tabla(campobits* tabla, Arbol T, campobits *bits);
+static long long comprimir_dos_pasadas(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap, const OpcionesHuffman* op, Arena arena);
+static long long descomprimir_dos_pasadas(BitReader in, int modo, long long cuenta, unsigned char* salida, size_t cap, CacheTabla* cache, Arena arena);
+static int calcular_frecuencias(unsigned long long* frecuencias, char* entrada);
+static int crear_huffman(const unsigned long long* frecuencias, ArbolPlano* T, Arena arena);
+static int crear_huffman_lineal(const unsigned long long* frecuencias, int num_simbolos, int* longitudes, Arena arena);
+static int crear_huffman_limitado(const unsigned long long* frecuencias, int num_simbolos, int max_longitud, unsigned char* longitudes, Arena arena);
+static int calcular_longitudes(const ArbolPlano* T, int nodo, int profundidad, int* longitudes);
+static unsigned long long costo_en_bits(const unsigned long long* frecuencias, const int* longitudes, int num_simbolos);
+static int codificar(const ArbolPlano* T, const unsigned char* longitudes, const unsigned char* datos, size_t n, BitWriter out, int modo);
+static void crear_tabla(campobits* tabla, const ArbolPlano* T, int nodo, campobits *bits);
+
+
+static int leer_arbol(BitReader bs, ArbolPlano* T);
+static TablaDec tabla_desde_arbol(const ArbolPlano* T, Arena arena);
+static TablaDec tabla_desde_longitudes(BitReader in, Arena arena);
+static TablaDec tabla_cacheada(BitReader in, CacheTabla* cache, Arena arena);
+static int decodificar(BitReader in, FILE* out, TablaDec t, const TablasContexto* contextos, long long cuenta);
+static size_t decodificar_memoria(BitReader in, TablaDec t, unsigned char* destino, size_t max);
 
+static int comprimir_bloques(FILE* in, const unsigned char* entrada, size_t tam_entrada, Salida* out, const OpcionesHuffman* op, Tanda* recursos);
+static int descomprimir_bloques(BitReader in, Salida* out, int hilos, Tanda* recursos);
+static long long comprimir_bloques_memoria(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap, const OpcionesHuffman* op, Arena arena);
+static long long descomprimir_bloques_memoria(BitReader in, unsigned char* salida, size_t cap, CacheTabla* cache, Arena arena);
+static long long comprimir_contexto(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap, const OpcionesHuffman* op, Arena arena);
+static long long descomprimir_contexto(BitReader in, long long cuenta, unsigned char* salida, size_t cap, CacheTabla* cache, Arena arena);
+static int agrupar_contextos(const unsigned long long* frecuencias, int limite, unsigned char* mapa, unsigned char* longitudes, Arena arena);
+static TablasContexto* leer_contextos(BitReader in, Arena arena);
+static size_t decodificar_contexto(BitReader in, const TablasContexto* tc, unsigned char* destino, size_t max, unsigned char* anterior);
+static long long comprimir_simbolos16(const unsigned char* datos, const unsigned short* simbolos, size_t n, int num_simbolos, int max_longitud, unsigned char* salida, size_t cap, Arena arena);
+static long long descomprimir_simbolos16(BitReader in, long long cuenta, unsigned char* datos, unsigned short* simbolos, size_t cap, CacheTabla* cache, Arena arena);
+static int leer_simbolos16(BitReader in, long long cuenta, TablaDec* tabla, int* ultimo, Arena arena);
+static int decodificar_simbolos16(BitReader in, FILE* out, long long cuenta);
+static size_t decodificar_simbolos(BitReader in, TablaDec t, unsigned short* destino, size_t max);
+static int tanda_preparar(Tanda* t, int hilos, int ranuras, size_t tam_datos, size_t tam_cuerpo);
+static void tanda_liberar(Tanda* t);
+static int tuberia_ejecutar(Tuberia* tb, TareaHilos leer, TareaHilos procesar, TareaHilos escribir);
+static void _tarea_leer_bloques(void* ctx, int r);
+static void _tarea_escribir_bloques(void* ctx, int r);
+static void _tarea_leer_cuerpos(void* ctx, int r);
+static void _tarea_escribir_datos(void* ctx, int r);
+static void _tarea_codificar(void* ctx, int i);
+static void _tarea_decodificar(void* ctx, int i);
+static unsigned int* leer_indice(BitReader in, Tanda* t, unsigned int* num_bloques);
+static long long codificar_bloque(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap, int max_longitud, int flujos, int* tipo, Arena arena);
+static int decodificar_bloque(const unsigned char* cuerpo, size_t tam, unsigned char* destino, size_t n, int tipo, CacheTabla* cache, Arena arena);
+static int decodificar_4(const unsigned char* cuerpo, size_t tam, TablaDec t, unsigned char* destino, size_t n);
+static size_t _vueltas_seguras(const unsigned char* p, const unsigned char* fin_p, const unsigned char* d, const unsigned char* fin_d, int bmax);
+static void _partir_4(size_t n, size_t* cuenta);
+static size_t cota_bloque(size_t n);
+static int elegir_tipo(const unsigned long long* frecuencias, size_t n);
+static long long guardar_sin_codigos(int modo, const unsigned char* datos, size_t n, unsigned char* salida, size_t cap);
+static long long descomprimir_sin_codigos(BitReader in, int modo, long long cuenta, unsigned char* salida, size_t cap);
+static int copiar_sin_codigos(BitReader in, FILE* out, int modo, long long cuenta);
+static FILE* _abrir(char* nombre, int escribir);
+static void _cerrar(FILE* f);
+static size_t _leer_completo(FILE* f, unsigned char* buf, size_t n);
+static unsigned char* _leer_archivo(char* nombre, size_t* tam);
+static int _escribir(Salida* s, const void* p, size_t n);
+static int _crecer(void** p, size_t* cap, size_t tam);
+static int _opciones_validas(const OpcionesHuffman* op);
+static void _escribir_cuenta(BitWriter out, unsigned long long n);
+static int _leer_cuenta(BitReader in, unsigned long long* n);
+static int _leer_modo(BitReader in, int* modo, long long* cuenta);
+static unsigned long long _reservas_arena(Arena a);
+static int _longitudes_tabla(const unsigned long long* f, int num_simbolos, int limite, unsigned char* l, Arena arena);
+static unsigned long long _costo_tabla(const unsigned long long* f, const unsigned char* l);
+static unsigned long long _bits_cabecera(const unsigned char* l);
+static unsigned long long _sumar_contextos(const unsigned long long* frecuencias, const unsigned char* elegidos, unsigned long long* suma);
+static int _simbolos_usados(const unsigned char* l);
+static int _ancho_bits(unsigned int v);
+static const unsigned short* _muestras(const unsigned char* datos, const unsigned short* simbolos, size_t i, size_t k, unsigned short* tramo);
+static void _bytes_muestras(const unsigned short* simbolos, size_t k, unsigned char* datos);
+static void _poner_u32(unsigned char* p, unsigned int v);
+static unsigned int _leer_u32(const unsigned char* p);
 
-static Arbol leer_arbol(BitStream bs);
-static void decodificar(BitStream in, BitStream out, Arbol arbol);
+static int comprimir_archivo(char* entrada, char* salida, const OpcionesHuffman* op);
+static int comprimir_flujo(char* entrada, char* salida, const OpcionesHuffman* op);
+static int descomprimir_archivo(char* entrada, char* salida, int mapear);
 
-static void imprimirNodo(Arbol nodo);
-static void imprimirNodoReconstruido(Arbol nodo);
-static int _es_hoja(Arbol nodo);
-static void _escribir_arbol(Arbol a, BitStream out);
-static Arbol _crear_nodo_interno(Arbol izq, Arbol der);
-static void _recorrer(Arbol a, BitStream in, BitStream out);
+#ifndef HUFFMAN_SIN_ESTADISTICAS
+static EstadisticasHuffman* _est_empezar(EstadisticasHuffman* e);
+static void _est_terminar(EstadisticasHuffman* e, EstadisticasHuffman* afuera);
+static void _est_sumar(EstadisticasHuffman* total, const EstadisticasHuffman* e);
+static EstadisticasHuffman* _est_trabajo(TrabajoBloque* b);
+static void _est_fin_trabajo(TrabajoBloque* b, EstadisticasHuffman* afuera);
+static void _est_sumar_tanda(const TrabajoBloque* tanda, int n);
+static void _marcar(Marca* m);
+static void _sumar_etapa(int etapa, Marca* m);
+#endif
+
+static ModeloHuffman modelo_desde_frecuencias(const unsigned long long* frecuencias, int max_longitud);
+static ModeloHuffman modelo_desde_longitudes(const unsigned char* longitudes);
+
+static LectorHuffman _lector_crear(const unsigned char* cabecera, const unsigned char* indice, unsigned int num, unsigned long long tam);
+static int _lector_bloque(LectorHuffman l, unsigned int i, unsigned char* destino);
+
+static int _es_hoja(const ArbolPlano* T, int nodo);
+static void _escribir_arbol(const ArbolPlano* T, int nodo, BitWriter out);
+static int _leer_nodo(BitReader bs, ArbolPlano* T, int profundidad);
 
 /*====================================================
      Implementacion de funciones publicas
@@ -215,57 +592,555 @@ static void _recorrer(Arbol a, BitStream in, BitStream out);
   Retorna 0 si no hay errores.
 */
 int comprimir(char* entrada, char* salida) {
-    
+    OpcionesHuffman op;
+    opciones_defecto(&op);
+    return comprimir_opciones(entrada, salida, &op);
+}
+
+/* Llena op con las opciones que usa comprimir() */
+void opciones_defecto(OpcionesHuffman* op) {
+    CONFIRM_RETURN(op);
+    op->modo = MODO_CANONICO;
+    op->max_longitud = 0;
+    op->constructor = CONSTRUCTOR_PQ;
+    op->tam_bloque = TAM_BLOQUE_DEFECTO;
+    op->hilos = 0;
+    op->flujos = 1;
+}
+
+/*
+  Comprime archivo entrada y lo escribe a archivo salida con las opciones dadas.
+  Es un envoltorio de comprimir_memoria: la entrada se mapea (o se lee entera)
+  y el resultado se arma en memoria y se escribe de una vez.
+  stdin no se sabe cuanto mide y solo se puede leer una vez, asi que se
+  comprime por bloques a medida que llega (comprimir_bloques).
+  
+  Retorna 0 si no hay errores.
+*/
+int comprimir_opciones(char* entrada, char* salida, const OpcionesHuffman* op) {
+    EST_EMPEZAR(est);
+    int error = comprimir_archivo(entrada, salida, op);
+    EST_TERMINAR(est);
+    return error;
+}
+
+static int comprimir_archivo(char* entrada, char* salida, const OpcionesHuffman* op) {
+    CONFIRM_NOTNULL(op, 1);
+    CONFIRM_NOTNULL(entrada, 1);
+    CONFIRM_NOTNULL(salida, 1);
+
+    if (strcmp(entrada, "-") == 0) {
+        return comprimir_flujo(entrada, salida, op);
+    }
+    CONFIRM_TRUE(_opciones_validas(op), 1);
+
+    /* si se puede, la entrada se lee directamente de memoria */
+    EST_NUEVA_MARCA(m);
+    const unsigned char* datos = NULL;
+    unsigned char* leidos = NULL;
+    size_t n = 0;
+    Mapeo mapa = mapeo_abrir(entrada);
+    if (mapa != NULL) {
+        datos = mapa->datos;
+        n = mapa->tam;
+    }
+    else {
+        leidos = _leer_archivo(entrada, &n);
+        CONFIRM_NOTNULL(leidos, 1);
+        datos = leidos;
+    }
+
+    EST_ETAPA(EST_ENTRADA_SALIDA, m);
+
+    size_t cap = comprimir_cota(n, op);
+    unsigned char* resultado = malloc(cap);
+    long long tam = resultado != NULL ? comprimir_memoria(datos, n, resultado, cap, op, NULL, 0) : -1;
+    int error = tam < 0;
+    if (error && resultado != NULL) {
+        // con memoria suficiente, en MODO_ARBOL falla un arbol mas profundo que lo que entra en campobits
+        if (op->modo == MODO_ARBOL) fprintf(stderr, "El arbol de %s tiene codigos de mas de %d bits, usar MODO_CANONICO\n", entrada, CANONICO_MAX_LONGITUD);
+        else fprintf(stderr, "No se pudo comprimir %s\n", entrada);
+    }
+    EST_MARCAR(m);
+    if (!error) {
+        FILE* out = _abrir(salida, 1);
+        error = out == NULL || fwrite(resultado, 1, (size_t)tam, out) != (size_t)tam;
+        _cerrar(out);
+    }
+    EST_ETAPA(EST_ENTRADA_SALIDA, m);
+    free(resultado);
+    free(leidos);
+    mapeo_cerrar(mapa);
+    return error;
+}
+
+/*
+  Como comprimir_opciones, pero la entrada no se mapea ni se lee entera: se
+  comprime por bloques (siempre MODO_BLOQUES) mientras se lee, con la lectura,
+  la codificacion y la escritura superpuestas (ver comprimir_bloques).
+  La memoria no depende del tamano del archivo.
+
+  Retorna 0 si no hay errores.
+*/
+int comprimir_tuberia(char* entrada, char* salida, const OpcionesHuffman* op) {
+    EST_EMPEZAR(est);
+    int error = comprimir_flujo(entrada, salida, op);
+    EST_TERMINAR(est);
+    return error;
+}
+
+/* Comprime entrada en MODO_BLOQUES a medida que se lee (tambien stdin)
+retorna 0 si no hay errores */
+static int comprimir_flujo(char* entrada, char* salida, const OpcionesHuffman* op) {
+    CONFIRM_NOTNULL(op, 1);
+    CONFIRM_NOTNULL(entrada, 1);
+    CONFIRM_NOTNULL(salida, 1);
+
+    OpcionesHuffman opciones = *op;
+    opciones.modo = MODO_BLOQUES;
+    CONFIRM_TRUE(_opciones_validas(&opciones), 1);
+
+    FILE* in = _abrir(entrada, 0);
+    FILE* out = in != NULL ? _abrir(salida, 1) : NULL;
+    Salida s = { out, NULL, 0, 0 };
+    int error = out != NULL ? comprimir_bloques(in, NULL, 0, &s, &opciones, NULL) : 1;
+    EST_CONTAR(bytes_salida, s.pos);
+    _cerrar(in);
+    _cerrar(out);
+    return error;
+}
+
+/*
+  Comprime los n bytes de datos en salida (de cap bytes) con las opciones dadas
+  (NULL = opciones_defecto). El resultado es igual al archivo de comprimir_opciones.
+  Con trabajo (tam_trabajo bytes, ver MEMORIA_TRABAJO) la memoria temporal sale de
+  ahi y todo se hace en este hilo; sin trabajo, en MODO_BLOQUES con op->hilos != 1
+  los bloques se codifican en el pool.
+
+  retorna el tamano del resultado, -1 si hubo error o no entra en cap
+*/
+long long comprimir_memoria(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap, const OpcionesHuffman* op, void* trabajo, size_t tam_trabajo) {
+    OpcionesHuffman defecto;
+    if (op == NULL) {
+        opciones_defecto(&defecto);
+        op = &defecto;
+    }
+    CONFIRM_TRUE(datos != NULL || n == 0, -1);
+    CONFIRM_NOTNULL(salida, -1);
+    CONFIRM_TRUE(_opciones_validas(op), -1);
+
+    // un compresor de una sola llamada; con trabajo todo se hace en este hilo
+    // (compresor_comprimir cuenta las estadisticas)
+    struct _CompresorHuffman c = { *op, NULL, { 0 } };
+    if (trabajo != NULL) c.op.hilos = 1;
+    c.arena = trabajo != NULL ? arena_crear_en(trabajo, tam_trabajo) : arena_crear(0);
+    CONFIRM_NOTNULL(c.arena, -1);
+    long long tam = compresor_comprimir(&c, datos, n, salida, cap);
+    tanda_liberar(&c.tanda);
+    arena_destruir(c.arena);
+    return tam;
+}
+
+/*
+  Tamano maximo del resultado de comprimir_memoria para n bytes.
+  Las longitudes salen de un codigo de huffman optimo (con o sin limite), que
+  nunca ocupa mas que el codigo fijo de 8 bits: los codigos ocupan a lo sumo n
+  bytes. Con mas de INT_MAX bytes crear_huffman redondea las frecuencias y se
+  puede pasar un poco (menos de n / 2^16).
+*/
+size_t comprimir_cota(size_t n, const OpcionesHuffman* op) {
+    OpcionesHuffman defecto;
+    if (op == NULL) {
+        opciones_defecto(&defecto);
+        op = &defecto;
+    }
+    if (op->modo == MODO_SIMBOLOS16) {
+        return simbolos_cota((n + 1) / 2, SIMBOLOS_MAX);
+    }
+    if (op->modo == MODO_CONTEXTO) {
+        // las tablas por contexto solo se usan si ocupan menos que una sola, mas la cantidad de tablas
+        return 2 + MAX_TAM_VARIABLE + MAX_CABECERA + n + (n >> 16) + 8;
+    }
+    if (op->modo != MODO_BLOQUES) {
+        return 1 + MAX_TAM_VARIABLE + MAX_CABECERA + n + (n >> 16) + 8;
+    }
+    size_t tam_bloque = op->tam_bloque > 0 ? (size_t)op->tam_bloque : TAM_BLOQUE_DEFECTO;
+    size_t bloques = n / tam_bloque + 1;
+    // cabecera del archivo, cada bloque con su cabecera y su entrada en el indice, marca de fin y pie
+    return 5 + bloques * (CABECERA_BLOQUE + cota_bloque(0) + 8) + n + CABECERA_BLOQUE + 8;
+}
+
+/*
+  Comprime con una pasada para las frecuencias y otra para codificar
+  (MODO_ARBOL y MODO_CANONICO). Si los codigos no ganan nada el resultado
+  queda en MODO_CRUDO o MODO_RLE (ver elegir_tipo). La memoria temporal sale de la arena.
+
+  retorna el tamano del resultado, -1 si hubo error o no entra en cap
+*/
+static long long comprimir_dos_pasadas(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap, const OpcionesHuffman* op, Arena arena) {
     /* 256 es el numero de caracteres ASCII.
        Asi podemos utilizar un unsigned char como indice.
        nota: le agregu {0} para inicializar las frceuencias a 0
+       los conteos son de 64 bits para archivos de mas de 2 GiB
      */
-    int frecuencias[NUM_CHARS] = {0};
-    Arbol arbol = NULL;
+    unsigned long long frecuencias[NUM_CHARS] = {0};
+    ArbolPlano arbol;
+    ArbolPlano* T = NULL;
     /* Primer recorrido - calcular frecuencias */
-    CONFIRM_TRUE(0 == calcular_frecuencias(frecuencias, entrada), 0);
+    EST_NUEVA_MARCA(m);
+    histograma_contar(datos, n, frecuencias);
+    EST_ETAPA(EST_HISTOGRAMA, m);
+
+    /* Si hay un solo caracter o los codigos no pueden ganar nada, no se arma el arbol */
+    int tipo = n > 0 ? elegir_tipo(frecuencias, n) : BLOQUE_HUFFMAN;
+    if (tipo != BLOQUE_HUFFMAN) {
+        return guardar_sin_codigos(tipo == BLOQUE_RLE ? MODO_RLE : MODO_CRUDO, datos, n, salida, cap);
+    }
             
-    arbol = crear_huffman(frecuencias);
-    arbol_imprimir(arbol, imprimirNodo); 
+    /* Longitudes de los codigos. Si el arbol queda mas profundo que el limite
+       (o que lo que entra en campobits) se usa el constructor limitado.
+       La pq y la memoria de los constructores salen de la arena */
+    int profundidad[NUM_CHARS] = {0};
+    unsigned char longitudes[NUM_CHARS];
+    int maxima = 0;
+    if (op->constructor == CONSTRUCTOR_LINEAL) {
+        maxima = crear_huffman_lineal(frecuencias, NUM_CHARS, profundidad, arena);
+        CONFIRM_TRUE(maxima >= 0, -1);
+    }
+    else {
+        CONFIRM_TRUE(0 == crear_huffman(frecuencias, &arbol, arena), -1);
+        T = &arbol;
+        maxima = calcular_longitudes(T, T->raiz, 0, profundidad);
+    }
+    int limite = op->max_longitud > 0 ? op->max_longitud : CANONICO_MAX_LONGITUD;
+    if (maxima > CANONICO_MAX_LONGITUD && op->modo == MODO_ARBOL) {
+        // el arbol no se puede limitar, el aviso lo da comprimir_archivo
+        return -1;
+    }
+    for (int i = 0; i < NUM_CHARS; i++) {
+        longitudes[i] = (unsigned char)profundidad[i];
+    }
+    unsigned long long sin_limite = costo_en_bits(frecuencias, profundidad, NUM_CHARS);
+    if (op->modo == MODO_CANONICO && maxima > limite) {
+        CONFIRM_TRUE(0 == crear_huffman_limitado(frecuencias, NUM_CHARS, limite, longitudes, arena), -1);
+        // profundidad queda con las longitudes limitadas: el costo de limitar es
+        // bits_codigos - bits_sin_limite en las estadisticas
+        maxima = 0;
+        for (int i = 0; i < NUM_CHARS; i++) {
+            profundidad[i] = longitudes[i];
+            if (profundidad[i] > maxima) maxima = profundidad[i];
+        }
+    }
+    EST_ETAPA(EST_ARBOL, m);
 
-    /* Segundo recorrido - Codificar archivo */
-    CONFIRM_TRUE(0 == codificar(arbol, entrada, salida), 0);
-    
-    arbol_destruir(arbol);
-    
-    return 0;
+    /* Con las longitudes se sabe cuanto ocuparia: si no es menos que los datos van tal cual.
+       El arbol en preorden ocupa 9 bits por hoja y 1 por nodo interno */
+    unsigned long long bits = costo_en_bits(frecuencias, profundidad, NUM_CHARS);
+    int usados = _simbolos_usados(longitudes);
+    unsigned long long cabecera = op->modo == MODO_CANONICO ? _bits_cabecera(longitudes) : 10 * (unsigned long long)usados - 1;
+    if (n > 0 && (bits + cabecera + 7) / 8 >= n) {
+        return guardar_sin_codigos(MODO_CRUDO, datos, n, salida, cap);
+    }
+    EST_CONTAR(simbolos, n);
+    EST_CONTAR(bits_codigos, bits);
+    EST_CONTAR(bits_sin_limite, sin_limite);
+    EST_MAXIMO(profundidad, maxima);
+
+    /* Segundo recorrido - Codificar, el escritor va en el stack */
+    struct _BitWriter escritor;
+    InitBitWriterMem(&escritor, salida, cap);
+    if (codificar(T, longitudes, datos, n, &escritor, op->modo) != 0) {
+        return -1;
+    }
+    return FlushBitWriterMem(&escritor);
 }
 
 
 /*
   Descomprime archivo entrada y lo escriba a archivo salida.
+  Si el archivo se puede mapear y se sabe cuanto mide lo descomprimido
+  (MODO_BLOQUES con indice) es un envoltorio de descomprimir_memoria,
+  si no se decodifica a medida que se lee.
   
   Retorna 0 si no hay errores.
 */
 int descomprimir(char* entrada, char* salida) {
+    EST_EMPEZAR(est);
+    int error = descomprimir_archivo(entrada, salida, 1);
+    EST_TERMINAR(est);
+    return error;
+}
 
-    BitStream in = 0;
-    BitStream out = 0;
-    Arbol arbol = NULL;
+/*
+  Como descomprimir, pero el archivo no se mapea ni se descomprime entero en
+  memoria: se decodifica a medida que se lee. En MODO_BLOQUES la lectura, la
+  decodificacion y la escritura se superponen (ver descomprimir_bloques) y la
+  memoria no depende del tamano del archivo.
+
+  Retorna 0 si no hay errores.
+*/
+int descomprimir_tuberia(char* entrada, char* salida) {
+    EST_EMPEZAR(est);
+    int error = descomprimir_archivo(entrada, salida, 0);
+    EST_TERMINAR(est);
+    return error;
+}
+
+/* Descomprime entrada en salida; si mapear es 0 siempre se lee como flujo
+retorna 0 si no hay errores */
+static int descomprimir_archivo(char* entrada, char* salida, int mapear) {
+
+    BitReader in = 0;
+    FILE* out = 0;
+    FILE* f = 0;
+    Mapeo mapa = NULL;
+    ArbolPlano arbol;
+    TablaDec tabla = NULL;
+    Arena arena = NULL;  /* MODO_CONTEXTO: las tablas de los contextos */
+    TablasContexto* contextos = NULL;
         
-    /* Abrir archivo de entrada */
-    in = OpenBitStream(entrada, "r");
+    /* Abrir archivo de entrada ("-" es stdin) */
+    CONFIRM_NOTNULL(entrada, 1);
+    CONFIRM_NOTNULL(salida, 1);
+    /* si se puede, el archivo comprimido se lee directamente de memoria */
+    EST_NUEVA_MARCA(m);
+    if (mapear && strcmp(entrada, "-") != 0) {
+        mapa = mapeo_abrir(entrada);
+    }
+    long long tam = mapa != NULL ? descomprimir_tamano(mapa->datos, mapa->tam) : -1;
+    EST_ETAPA(EST_ENTRADA_SALIDA, m);
+    if (tam >= 0) {
+        unsigned char* resultado = malloc(tam > 0 ? (size_t)tam : 1);
+        int error = resultado == NULL || descomprimir_memoria(mapa->datos, mapa->tam, resultado, (size_t)tam, NULL, 0) != tam;
+        if (error && resultado != NULL) fprintf(stderr, "Datos comprimidos invalidos en %s\n", entrada);
+        EST_MARCAR(m);
+        if (!error) {
+            out = _abrir(salida, 1);
+            error = out == NULL || fwrite(resultado, 1, (size_t)tam, out) != (size_t)tam;
+            _cerrar(out);
+        }
+        EST_ETAPA(EST_ENTRADA_SALIDA, m);
+        free(resultado);
+        mapeo_cerrar(mapa);
+        return error;
+    }
+    if (mapa != NULL) {
+        in = OpenBitReaderMem(mapa->datos, mapa->tam);
+        EST_CONTAR(bytes_entrada, mapa->tam);
+    }
+    else {
+        f = _abrir(entrada, 0);
+        CONFIRM_NOTNULL(f, 1);
+        in = OpenBitReaderStream(f);
+    }
+    if (in == NULL) {
+        _cerrar(f);
+        mapeo_cerrar(mapa);
+        return 1;
+    }
     
-    // LEER Y RECONSTRUIR EL ARBOL -------------
-    /* Leer Arbol de Huffman */
-    arbol = leer_arbol(in);
-    arbol_imprimir(arbol, imprimirNodoReconstruido);
+    // LEER LA CABECERA Y ARMAR LA TABLA DE DECODIFICACION -------------
+    int modo = -1;
+    long long cuenta = -1;
+    if (_leer_modo(in, &modo, &cuenta) != 0) {
+        modo = -1;
+    }
+    if (modo == MODO_BLOQUES) {
+        /* Cada bloque trae su propia tabla */
+        int error = 1;
+        out = _abrir(salida, 1);
+        if (out != NULL) {
+            Salida s = { out, NULL, 0, 0 };
+            error = descomprimir_bloques(in, &s, 0, NULL);
+            if (error) fprintf(stderr, "Bloque invalido en %s\n", entrada);
+            EST_CONTAR(bytes_salida, s.pos);
+            _cerrar(out);
+        }
+        CloseBitReader(in);
+        _cerrar(f);
+        mapeo_cerrar(mapa);
+        return error;
+    }
+    if (modo == MODO_SIMBOLOS16) {
+        /* Muestras de 16 bits, se decodifican de a tramos */
+        int error = 1;
+        out = _abrir(salida, 1);
+        if (out != NULL) {
+            error = decodificar_simbolos16(in, out, cuenta);
+            if (error) fprintf(stderr, "Datos comprimidos invalidos en %s\n", entrada);
+            _cerrar(out);
+        }
+        CloseBitReader(in);
+        _cerrar(f);
+        mapeo_cerrar(mapa);
+        return error;
+    }
+    if (modo == MODO_CRUDO || modo == MODO_RLE) {
+        /* Los datos van tal cual, o el caracter repetido */
+        int error = 1;
+        out = _abrir(salida, 1);
+        if (out != NULL) {
+            error = copiar_sin_codigos(in, out, modo, cuenta);
+            if (error) fprintf(stderr, "Faltan datos en %s\n", entrada);
+            _cerrar(out);
+        }
+        CloseBitReader(in);
+        _cerrar(f);
+        mapeo_cerrar(mapa);
+        return error;
+    }
+    if (cuenta == 0 && (modo == MODO_ARBOL || modo == MODO_CANONICO || modo == MODO_CONTEXTO)) {
+        /* Archivo vacio, no hay arbol ni codigos */
+        out = _abrir(salida, 1);
+        CloseBitReader(in);
+        _cerrar(f);
+        mapeo_cerrar(mapa);
+        _cerrar(out);
+        return out == NULL;
+    }
+    if (modo == MODO_ARBOL) {
+        /* Leer Arbol de Huffman */
+        if (leer_arbol(in, &arbol) == 0) {
+            tabla = tabla_desde_arbol(&arbol, NULL);
+        }
+    }
+    else if (modo == MODO_CANONICO) {
+        /* Leer las longitudes, no hace falta el arbol */
+        tabla = tabla_desde_longitudes(in, NULL);
+    }
+    else if (modo == MODO_CONTEXTO) {
+        /* Una tabla por cada grupo de contextos */
+        arena = arena_crear(0);
+        contextos = leer_contextos(in, arena);
+    }
+    EST_ETAPA(EST_TABLA, m);
+    if (tabla == NULL && contextos == NULL) {
+        fprintf(stderr, "Cabecera invalida en %s\n", entrada);
+        arena_destruir(arena);
+        CloseBitReader(in);
+        _cerrar(f);
+        mapeo_cerrar(mapa);
+        return 1;
+    }
 
     // LEER EL TEXTO COMPRIMIDO  Y DESCOMPRIMIR
     /* Abrir archivo de salida */
-    out = OpenBitStream(salida, "w");
+    out = _abrir(salida, 1);
+    if (out == NULL) {
+        tabladec_destruir(tabla);
+        arena_destruir(arena);
+        CloseBitReader(in);
+        _cerrar(f);
+        mapeo_cerrar(mapa);
+        return 1;
+    }
 
     /* Decodificar archivo */
-    decodificar(in, out, arbol);
+    int error = decodificar(in, out, tabla, contextos, cuenta);
+    if (error) fprintf(stderr, "Faltan datos en %s\n", entrada);
     
-    CloseBitStream(in);
-    CloseBitStream(out);
-    return 0;
+    tabladec_destruir(tabla);
+    arena_destruir(arena);
+    CloseBitReader(in);
+    _cerrar(f);
+    mapeo_cerrar(mapa);
+    _cerrar(out);
+    return error;
+}
+
+/*
+  Descomprime los tam bytes de datos (cualquier formato de comprimir_opciones)
+  en salida, de cap bytes. Con trabajo (tam_trabajo bytes, ver MEMORIA_TRABAJO)
+  las tablas salen de ahi y los bloques se decodifican en este hilo; sin trabajo
+  los bloques de MODO_BLOQUES se decodifican en el pool.
+
+  retorna el tamano descomprimido, -1 si hubo error o no entra en cap
+*/
+long long descomprimir_memoria(const unsigned char* datos, size_t tam, unsigned char* salida, size_t cap, void* trabajo, size_t tam_trabajo) {
+    CONFIRM_TRUE(datos != NULL && tam > 0, -1);
+    CONFIRM_TRUE(salida != NULL || cap == 0, -1);
+
+    // un descompresor de una sola llamada; con trabajo todo se hace en este hilo
+    struct _DescompresorHuffman d = { trabajo != NULL ? 1 : 0, NULL, { { 0 }, NULL }, { 0 } };
+    d.arena = trabajo != NULL ? arena_crear_en(trabajo, tam_trabajo) : arena_crear(0);
+    CONFIRM_NOTNULL(d.arena, -1);
+    long long resultado = descompresor_descomprimir(&d, datos, tam, salida, cap);
+    tanda_liberar(&d.tanda);
+    arena_destruir(d.arena);
+    return resultado;
+}
+
+/*
+  Tamano que tendran los tam bytes de datos descomprimidos, sin descomprimirlos:
+  la cantidad de caracteres de la cabecera, o en MODO_BLOQUES la suma de los
+  tamanos originales del indice de bloques.
+  retorna -1 si no se sabe (archivos viejos sin la cantidad, o sin indice)
+*/
+long long descomprimir_tamano(const unsigned char* datos, size_t tam) {
+    CONFIRM_TRUE(datos != NULL, -1);
+    if (tam > 0 && (datos[0] & MODO_CON_CUENTA) != 0) {
+        struct _BitReader lector;
+        InitBitReaderMem(&lector, datos, tam);
+        int modo = 0;
+        long long cuenta = -1;
+        return _leer_modo(&lector, &modo, &cuenta) != 0 ? -1 : cuenta;
+    }
+    if (tam < 5 + CABECERA_BLOQUE + 8 || datos[0] != MODO_BLOQUES) return -1;
+    if (_leer_u32(datos + tam - 4) != INDICE_MAGIA) return -1;
+    size_t num = _leer_u32(datos + tam - 8);
+    if (num > (tam - 5 - CABECERA_BLOQUE - 8) / 8) return -1;
+
+    const unsigned char* p = datos + tam - 8 - num * 8;
+    long long total = 0;
+    for (size_t i = 0; i < num; i++) {
+        total += _leer_u32(p + 8 * i);
+    }
+    return total;
+}
+
+/*
+  Decodifica lo que sigue a la cabecera de modo (MODO_ARBOL o MODO_CANONICO) en salida:
+  exactamente cuenta caracteres, o si es -1 (archivos viejos) hasta que se terminen los bits.
+  La tabla sale de la arena; en MODO_CANONICO se reusa la de cache si las longitudes son las mismas.
+
+  retorna el tamano descomprimido, -1 si hubo error o no entra en cap
+*/
+static long long descomprimir_dos_pasadas(BitReader in, int modo, long long cuenta, unsigned char* salida, size_t cap, CacheTabla* cache, Arena arena) {
+    ArbolPlano arbol;
+    TablaDec tabla = NULL;
+    if (cuenta == 0) {
+        return 0; // no hay arbol ni codigos
+    }
+    if (cuenta > 0 && (unsigned long long)cuenta > cap) {
+        return -1;
+    }
+    EST_NUEVA_MARCA(m);
+    if (modo == MODO_ARBOL) {
+        /* Leer Arbol de Huffman */
+        if (leer_arbol(in, &arbol) == 0) {
+            // la tabla del arbol no queda en cache
+            cache->tabla = NULL;
+            arena_vaciar(arena);
+            tabla = tabla_desde_arbol(&arbol, arena);
+        }
+    }
+    else {
+        /* Leer las longitudes, no hace falta el arbol */
+        tabla = tabla_cacheada(in, cache, arena);
+    }
+    if (tabla == NULL) return -1;
+    EST_ETAPA(EST_TABLA, m);
+
+    // archivos viejos sin la cuenta: hasta que se terminen los bits
+    size_t n = decodificar_memoria(in, tabla, salida, cuenta > 0 ? (size_t)cuenta : cap);
+    EST_ETAPA(EST_DECODIFICAR, m);
+    EST_CONTAR(simbolos, n);
+    if (cuenta > 0) {
+        return n == (size_t)cuenta ? cuenta : -1;
+    }
+    // si se lleno salida y quedan mas bits que el relleno del ultimo byte, no entraba
+    int lleno = n == cap && FillBits(in) > 7;
+    return lleno ? -1 : (long long)n;
 }
 
 /*====================================================
@@ -273,7 +1148,7 @@ int descomprimir(char* entrada, char* salida) {
   ====================================================*/
 
 /* Devuelve 0 si no hay errores */
-static int calcular_frecuencias(int* frecuencias, char* entrada) {
+static int calcular_frecuencias(unsigned long long* frecuencias, char* entrada) {
 
 
     /* Este metodo recorre el archivo contando la frecuencia
@@ -281,43 +1156,54 @@ static int calcular_frecuencias(int* frecuencias, char* entrada) {
        el arreglo frecuencias
     */
 
-    // leer el contenido del archivo caracter por caracter; imprimir error si no se encuentra
-    FILE* f = fopen(entrada, "r");
+    // leer el contenido del archivo de a bloques grandes; imprimir error si no se encuentra
+    // (fgetc toma el lock del FILE en cada caracter)
+    FILE* f = fopen(entrada, "rb");
     if (f == NULL) {
         perror("Error al abrir el archivo");
         return 1;
     }
-    while (1) {
-        char c = fgetc(f);
-        if (c == EOF) {
-            break;
-        }
-        // aumentar el conteo del caracter correspondiente en el array de ascii
-        // castear a unsigned char para asegurar que los chars sean del 0 a 255
-        //frecuencias[(unsigned char)c]++;
-        frecuencias[c]++;
-    }
+    int error = histograma_archivo(f, frecuencias);
     fclose(f);
     
-    return 0;
+    return error;
 }
 
 
-/* Crea el arbol huffman en base a las frecuencias dadas */
-static Arbol crear_huffman(int* frecuencias) {
+/* Crea el arbol huffman en base a las frecuencias dadas, en el arreglo plano T
+la pq sale de la arena
+retorna 0 si no hay errores */
+static int crear_huffman(const unsigned long long* frecuencias, ArbolPlano* T, Arena arena) {
+    CONFIRM_NOTNULL(T, 1);
+    // las prioridades de la pq son int: si la suma no entra se dividen a la mitad
+    // (redondeando hacia arriba para que ningun caracter usado quede en 0)
+    int prioridades[NUM_CHARS];
+    int escala = 0;
+    while (1) {
+        unsigned long long total = 0;
+        for (int i = 0; i < NUM_CHARS; i++) {
+            unsigned long long f = frecuencias[i] == 0 ? 0 : ((frecuencias[i] - 1) >> escala) + 1;
+            prioridades[i] = f > INT_MAX ? INT_MAX : (int)f;
+            total += f;
+        }
+        if (total <= INT_MAX) break;
+        escala++;
+    }
+
     // 1. crear la pq y verificar su creacion correcta
-    PQ pq = pq_create();
-    if (pq == NULL) { return NULL; }
+    PQ pq = pq_create_arena(arena);
+    if (pq == NULL) { return 1; }
+    T->num = 0;
+    T->raiz = -1;
 
-    // recorrer array de ascii y agregar a pq los caracteres con frecuencia > 0
+    // recorrer array de ascii y agregar a pq una hoja por cada caracter con frecuencia > 0
+    // el valor en la pq es la direccion del nodo dentro del arreglo
     for (int i = 0; i < 256; i++) {
-        if (frecuencias[i] > 0) {
-            char* ch = malloc(sizeof(char));
-            if (ch == NULL) { return NULL; }
-            *ch = (char)i;
-            pq_add(pq, ch, frecuencias[i], 0);
-            printf("AGREGAR A PQ: '%c' (ASCII %d), FRECUENCIA: %d\n", *ch, i, frecuencias[i]);
-
+        if (prioridades[i] > 0) {
+            NodoPlano* hoja = &T->nodos[T->num++];
+            hoja->izq = HOJA;
+            hoja->der = (short)i;
+            if (!pq_add(pq, hoja, prioridades[i], 0)) { pq_destroy(pq); return 1; }
         }
     }
  
@@ -326,83 +1212,248 @@ static Arbol crear_huffman(int* frecuencias) {
    */
     while (pq->size > 1) {
         // sacar los dos primeros 
-        PrioValue pv1 = NULL;
-        PrioValue pv2 = NULL;        
-        pq_remove(pq, (void**)&pv1);
-        pq_remove(pq, (void**)&pv2);
-        if (pv1 == NULL || pv2 == NULL) { return NULL; }
-        /*
-        / si pv1 aun no es un arbol, convertir su valor a char
-        if (pv1->es_arbol != 0) {
-            char1 = (char*)pv1->value;
-            izq = arbol_crear(char1);
-        }
-        else {
-            izq = (Arbol)(pv1->value);
-        }
-        if (pv2->es_arbol != 0) {
-            char2 = (char*)pv2->value;
-            der = arbol_crear(char1);
+        struct _PrioValue e1;
+        struct _PrioValue e2;
+        if (!pq_remove(pq, &e1) || !pq_remove(pq, &e2)) { pq_destroy(pq); return 1; }
+        PrioValue pv1 = &e1;
+        PrioValue pv2 = &e2;
+
+        int suma = pv1->prio + pv2->prio;
+
+        // crear el nuevo nodo interno al final del arreglo, con los nodos de pv1 y pv2 como hijos
+        // (hojas o arboles, da igual: los dos ya son nodos del arreglo)
+        NodoPlano* nodo = &T->nodos[T->num++];
+        nodo->izq = (short)((NodoPlano*)pv1->value - T->nodos);
+        nodo->der = (short)((NodoPlano*)pv2->value - T->nodos);
+     
+        // meter el arbol de nuevo en pq
+        if (!pq_add(pq, nodo, suma, 1)) { pq_destroy(pq); return 1; }
+    }
+    // al final, queda un solo elemento en pq, que es la raiz (o ninguno si no habia caracteres)
+    struct _PrioValue e;
+    PrioValue pv = pq_remove(pq, &e) ? &e : NULL;
+    if (pv != NULL) {
+        T->raiz = (int)((NodoPlano*)pv->value - T->nodos);
+    }
+    // limpieza
+    pq_destroy(pq);
+    return 0;
+}
+
+/*
+  Construccion de Huffman en tiempo lineal con dos colas (van Leeuwen).
+  
+  Con los simbolos ordenados por frecuencia, los nodos internos se crean
+  en orden creciente de peso, asi que alcanzan dos colas FIFO: una con las
+  hojas ordenadas y otra con los nodos internos en el orden en que se
+  crean. En cada paso se saca el menor de los dos frentes, dos veces.
+  Todo vive en un solo arreglo plano: hojas en 0..n-1 e internos en n..2n-2,
+  sin pq ni un nodo de Arbol por cada union. La memoria sale de la arena.
+  
+  Guarda en longitudes el tamano del codigo de cada simbolo (0 si no se usa)
+  retorna la longitud maxima, -1 si hubo error
+*/
+static int _comparar_clave(const void* a, const void* b) {
+    unsigned long long x = *(const unsigned long long*)a;
+    unsigned long long y = *(const unsigned long long*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int crear_huffman_lineal(const unsigned long long* frecuencias, int num_simbolos, int* longitudes, Arena arena) {
+    CONFIRM_NOTNULL(frecuencias, -1);
+    CONFIRM_NOTNULL(longitudes, -1);
+    memset(longitudes, 0, sizeof(int) * num_simbolos);
+
+    // un solo bloque de memoria: claves para ordenar, pesos y padres de cada nodo
+    unsigned long long* clave = arena_pedir(arena, sizeof(unsigned long long) * num_simbolos * 3 + sizeof(int) * num_simbolos * 2);
+    CONFIRM_NOTNULL(clave, -1);
+    unsigned long long* peso = clave + num_simbolos;
+    int* padre = (int*)(peso + 2 * num_simbolos);
+
+    // ordenar los simbolos usados por (frecuencia, simbolo)
+    int n = 0;
+    for (int s = 0; s < num_simbolos; s++) {
+        if (frecuencias[s] > 0) {
+            // la frecuencia tiene que entrar en los 44 bits de arriba (16 TiB)
+            if (frecuencias[s] >= (1ULL << 44)) {
+                return -1;
+            }
+            clave[n++] = (frecuencias[s] << 20) | (unsigned long long)s;
         }
-        else {
-            der = (Arbol)(pv2->value);
+    }
+    if (n < 2) {
+        // con un solo simbolo el arbol es una hoja y su codigo es vacio
+        return 0;
+    }
+    qsort(clave, n, sizeof(unsigned long long), _comparar_clave);
+    for (int i = 0; i < n; i++) {
+        peso[i] = clave[i] >> 20;
+    }
+
+    // hoja: frente de la cola de hojas, interno: frente de la cola de internos
+    int hoja = 0;
+    int interno = n;
+    for (int k = n; k < 2 * n - 1; k++) {
+        int elegidos[2];
+        for (int j = 0; j < 2; j++) {
+            if (hoja < n && (interno >= k || peso[hoja] <= peso[interno])) {
+                elegidos[j] = hoja++;
+            }
+            else {
+                elegidos[j] = interno++;
+            }
         }
+        peso[k] = peso[elegidos[0]] + peso[elegidos[1]];
+        padre[elegidos[0]] = k;
+        padre[elegidos[1]] = k;
+    }
 
-        
-        char* char1 = (char*)malloc(sizeof(char));
-        char* char2 = (char*)malloc(sizeof(char));
-        Arbol izq;
-        Arbol der;
+    // profundidades de arriba hacia abajo: la raiz es el ultimo nodo y cada padre esta despues de sus hijos
+    int* profundidad = (int*)peso; // los pesos ya no hacen falta
+    int maxima = 0;
+    profundidad[2 * n - 2] = 0;
+    for (int k = 2 * n - 3; k >= 0; k--) {
+        profundidad[k] = profundidad[padre[k]] + 1;
+    }
+    for (int i = 0; i < n; i++) {
+        int s = (int)(clave[i] & 0xFFFFF);
+        longitudes[s] = profundidad[i];
+        if (profundidad[i] > maxima) maxima = profundidad[i];
+    }
+    return maxima;
+}
+
+/*
+  Calcula longitudes de codigo de a lo sumo max_longitud bits con el algoritmo
+  package-merge (Larmore y Hirschberg), que da el codigo optimo con ese limite.
 
-        */
+  La idea: cada simbolo es una "moneda" de valor 2^-l por cada nivel l.
+  En el nivel mas profundo solo estan los simbolos; en cada nivel de
+  arriba se juntan de a dos los elementos del nivel de abajo (paquetes) y se
+  mezclan con los simbolos, ordenados por peso. De la lista final se toman
+  los 2n-2 elementos mas livianos, y la longitud de un simbolo es cuantas
+  veces aparece adentro de ellos. La memoria sale de la arena.
 
-        int suma = pv1->prio + pv2->prio;
-        printf("\nSuma de prioridades es:% d", suma);
-        // puntero a un int para el valor del arbol
-        int* pSuma = malloc(sizeof(int));
-        if (pSuma == NULL) return NULL;
-        *pSuma = suma;
+  Retorna 0 si no hay errores.
+*/
+typedef struct _nodopm {
+    unsigned long long peso;
+    int simbolo;  // >= 0 si es un simbolo, -1 si es un paquete
+    int izq;      // hijos del paquete (indices en el arreglo de nodos)
+    int der;
+} nodopm;
 
-        // crear el nuevo arbol con la suma como valor de raiz, y los caracteres/arboles de pv1 y pv2 como hijos
-        Arbol arbol = arbol_crear(pSuma);
-        printf("se creo el arbol con valor: %d", *pSuma);
+static void _contar_paquete(const nodopm* nodos, int i, unsigned char* longitudes) {
+    if (nodos[i].simbolo >= 0) {
+        longitudes[nodos[i].simbolo]++;
+        return;
+    }
+    _contar_paquete(nodos, nodos[i].izq, longitudes);
+    _contar_paquete(nodos, nodos[i].der, longitudes);
+}
 
-        // si el valor de pv1 o pv2 ya es un arbol, no se necesita crear un nuevo nodo; si aun es un char se crea el nodo
-        Arbol izq = pv1->es_arbol == 1 ? (Arbol)(pv1->value) : arbol_crear(pv1->value);
-        Arbol der = pv2->es_arbol == 1 ? (Arbol)(pv2->value) : arbol_crear(pv2->value);
+static int crear_huffman_limitado(const unsigned long long* frecuencias, int num_simbolos, int max_longitud, unsigned char* longitudes, Arena arena) {
+    CONFIRM_NOTNULL(frecuencias, 1);
+    CONFIRM_NOTNULL(longitudes, 1);
+    CONFIRM_TRUE(max_longitud > 0 && max_longitud <= CANONICO_MAX_LONGITUD, 1);
+    memset(longitudes, 0, num_simbolos);
 
-        if (arbol == NULL || izq == NULL || der == NULL) return NULL;
-        
-        // agregar hijos al arbol 
-        arbol_agregarIzq(arbol, izq);
-        arbol_agregarDer(arbol, der);
-     
-        // meter el arbol de nuevo en pq
-        pq_add(pq, arbol, suma, 1);
+    // simbolos usados ordenados por (frecuencia, simbolo), con las mismas claves que crear_huffman_lineal
+    // (con alfabetos de 64K la insercion no alcanza)
+    unsigned long long* hojas = arena_pedir(arena, sizeof(unsigned long long) * num_simbolos);
+    CONFIRM_NOTNULL(hojas, 1);
+    int n = 0;
+    for (int s = 0; s < num_simbolos; s++) {
+        if (frecuencias[s] == 0) continue;
+        if (frecuencias[s] >= (1ULL << 44)) return 1;
+        hojas[n++] = (frecuencias[s] << 20) | (unsigned long long)s;
+    }
+    qsort(hojas, n, sizeof(unsigned long long), _comparar_clave);
+    if (n < 2 || (max_longitud < 31 && n > (1 << max_longitud))) {
+        // con un solo simbolo no hay codigo, y con mas de 2^max simbolos no hay solucion
+        return n < 2 ? 0 : 1;
     }
-    // al final, queda un solo elemento en pq, que es el arbol
-    PrioValue pv = NULL;
-    pq_remove(pq, (void**)&pv);
-    printf("ya se termino el arbol");
 
-    if (pv == NULL) { return 0; }
-    printf("\nprioridad: %d", pv->prio);
-    Arbol a = (Arbol)pv->value;
-    int *numero = (int*)arbol_valor(a);
-    
-    printf("se obtuvo un arbol con valor en la raiz: %d", *numero); // error aqui
-    // limpieza
-    pq_destroy(pq);
-    // retornar el arbol resultante
-    return a;
+    // los nodos 0..n-1 son los simbolos, los paquetes se agregan detras
+    nodopm* nodos = arena_pedir(arena, sizeof(nodopm) * (size_t)n * (max_longitud + 1));
+    int* lista = arena_pedir(arena, sizeof(int) * 2 * n);
+    int* nueva = arena_pedir(arena, sizeof(int) * 2 * n);
+    if (nodos == NULL || lista == NULL || nueva == NULL) {
+        return 1;
+    }
+    for (int i = 0; i < n; i++) {
+        nodos[i].peso = hojas[i] >> 20;
+        nodos[i].simbolo = (int)(hojas[i] & 0xFFFFF);
+        nodos[i].izq = nodos[i].der = -1;
+        lista[i] = i;
+    }
+    int num_nodos = n;
+    int tam = n;
+
+    // subir nivel por nivel: paquetes del nivel de abajo mezclados con los simbolos
+    for (int nivel = 1; nivel < max_longitud; nivel++) {
+        int paquetes = tam / 2;
+        int p = 0, h = 0, k = 0;
+        while (k < 2 * n - 2 && (p < paquetes || h < n)) {
+            unsigned long long peso_p = 0;
+            if (p < paquetes) {
+                peso_p = nodos[lista[2 * p]].peso + nodos[lista[2 * p + 1]].peso;
+            }
+            if (h < n && (p >= paquetes || nodos[h].peso <= peso_p)) {
+                nueva[k++] = h++;
+            }
+            else {
+                nodopm* paq = &nodos[num_nodos];
+                paq->peso = peso_p;
+                paq->simbolo = -1;
+                paq->izq = lista[2 * p];
+                paq->der = lista[2 * p + 1];
+                nueva[k++] = num_nodos++;
+                p++;
+            }
+        }
+        int* tmp = lista;
+        lista = nueva;
+        nueva = tmp;
+        tam = k;
+    }
+
+    // la longitud de cada simbolo es cuantas veces aparece en los 2n-2 primeros
+    for (int i = 0; i < 2 * n - 2 && i < tam; i++) {
+        _contar_paquete(nodos, lista[i], longitudes);
+    }
+    return 0;
+}
+
+/* Guarda en longitudes la profundidad de cada hoja (el tamano de su codigo)
+retorna la profundidad maxima */
+static int calcular_longitudes(const ArbolPlano* T, int nodo, int profundidad, int* longitudes) {
+    CONFIRM_TRUE(T, 0);
+    if (nodo < 0) return 0; // arbol vacio
+    if (_es_hoja(T, nodo)) {
+        longitudes[(unsigned char)T->nodos[nodo].der] = profundidad;
+        return profundidad;
+    }
+    int izq = calcular_longitudes(T, T->nodos[nodo].izq, profundidad + 1, longitudes);
+    int der = calcular_longitudes(T, T->nodos[nodo].der, profundidad + 1, longitudes);
+    return izq > der ? izq : der;
+}
+
+/* Tamano en bits de los datos codificados con esas longitudes */
+static unsigned long long costo_en_bits(const unsigned long long* frecuencias, const int* longitudes, int num_simbolos) {
+    unsigned long long total = 0;
+    for (int s = 0; s < num_simbolos; s++) {
+        total += frecuencias[s] * (unsigned long long)longitudes[s];
+    }
+    return total;
 }
 
 
 
 
-static int codificar(Arbol T, char* entrada, char* salida) {
-    FILE* in = NULL;
-    BitStream out = NULL;
+/* Escribe en out la cabecera y los codigos de los n bytes de datos
+retorna 0 si no hay errores */
+static int codificar(const ArbolPlano* T, const unsigned char* longitudes, const unsigned char* datos, size_t n, BitWriter out, int modo) {
     /* Dado el arbol crear una tabla que contiene la
        secuencia de bits para cada caracter.
        
@@ -414,120 +1465,54 @@ static int codificar(Arbol T, char* entrada, char* salida) {
     */
     // el indice del elemento corresponde a su ascii
     campobits tabla[NUM_CHARS];
+    size_t i = 0;
 
     /* Inicializar tabla de campo de bits a cero */
     memset(tabla, 0, NUM_CHARS*sizeof(struct _campobits));
 
-    // crear un campobits que usaremos para guardar los codigos mientras recorremos el rbol
-    campobits* bits = (campobits*)malloc(sizeof(struct _campobits));
-    CONFIRM_NOTNULL(bits, 1);
-    bits->bits = 0;
-    bits->tamano = 0;
+    // campobits que usaremos para guardar los codigos mientras recorremos el rbol
+    campobits bits = { 0, 0 };
 
-    // recorrer el arbol, poniendo el 'codigo' de cada caracter en la tabla
-    crear_tabla(tabla, T, bits);
-
-    // creacion del archivo bitstream
-    int i = 0;
-    int j = 0;
-
-    out = OpenBitStream(salida, "w");
-
-    // ESCRITURA DEL ARBOL -----------------------------------------
-    // escribimos en preorden el arbol en el archivo de salida
-    arbol_preorden(T, _escribir_arbol, out);
-
-
-    // COMPRESION DEL TEXTO  ---------------------------------------
-    // abirir el archivo de entrada
-    in = fopen(entrada, "r");
-    if (in == NULL) {
-        perror("Error al abrir el archivo");
-        return 1;
-    }
-    campobits* b = NULL;
-    while (1) {
-        char c = fgetc(in);
-        if (c == EOF) {
-            break;
-        }
-        //b = &tabla[c]; 
-        /*
-        for (i = 0; i < b->tamano; i++) { //escribir los bits del campobit, es decir el codigo del caracter
-            int bit = bits_leer(b, i);
-            PutBit(out, bit);
-        }
-        */
-
-        // buscar el campobits correspondiente en la tabla (indice = ascii del caracter) 
-        // recorrer sus bits y poner en el archivo
-        for (i = 0; i < tabla[c].tamano; i++) {
-            int bit = 0 != (tabla[c].bits & (0x1 << i));
-            PutBit(out, bit);
+    // en modo canonico solo importan las longitudes, los codigos se derivan de ellas
+    EST_NUEVA_MARCA(m);
+    unsigned int codigos[NUM_CHARS];
+    if (modo == MODO_CANONICO) {
+        CONFIRM_TRUE(0 == canonico_codigos(longitudes, NUM_CHARS, codigos), 1);
+        for (i = 0; i < NUM_CHARS; i++) {
+            tabla[i].bits = codigos[i];
+            tabla[i].tamano = longitudes[i];
         }
     }
+    else {
+        // recorrer el arbol, poniendo el 'codigo' de cada caracter en la tabla
+        crear_tabla(tabla, T, T != NULL ? T->raiz : -1, &bits);
+    }
+    EST_ETAPA(EST_TABLA, m);
 
-    // liberar memoria utilizada
-    free(b);
-   
-
-    
-    /* Abrir archivos */
-    /* TU IMPLEMENTACION VA AQUI .. */
-
-    
-    /* Escribir arbol al archivo de salida */
-
-    /* TU IMPLEMENTACION VA AQUI .. 
-
-
-        Nota: puedes utilizar arbol_preorden() para lograr esto
-        facilmente.
-        
-        El truco es que al escribir el arbol, 
-           - Si no es hoja: 
-               escribe un bit 0 
-           - Si es hoja:
-                bit 1 seguido por el byte ASCII que representa el caracter 
-        
-        Para escribir bits utiliza PutBits() de bitstream.h
-        Para escribir bytes utiliza PutByte() de bitstream.h
-    */
-    
-
-
-    /* Escribir el texto codificado al archivo*/
+    // ESCRITURA DE LA CABECERA -------------------------------------
+    // el primer byte indica el formato, despues va la cantidad de caracteres
+    PutBits(out, (unsigned long long)(modo | MODO_CON_CUENTA), 8);
+    _escribir_cuenta(out, n);
+    if (modo == MODO_CANONICO) {
+        // solo las longitudes de los codigos
+        canonico_escribir(out, longitudes, NUM_CHARS);
+    }
+    else {
+        // escribimos en preorden el arbol en el archivo de salida
+        if (T != NULL && T->raiz >= 0) _escribir_arbol(T, T->raiz, out);
+    }
 
-    /* 
-        TU IMPLEMENTACION VA AQUI .. 
-        
-        
-        Lee todos los datos de nuevo del archivo de entrada
-        y agregalos al archivo de salida utilizando la
-        tabla de conversion.
-        
-        Recuerda que tienes que escribir bit por bit utilzando
-        PutBit() de bitstream.h. Por ejemplo, dado una secuencia
-        de bits podrias escribirlo al archivo asi:
-        
-            /- Esto escribe todos los bits en un campobits a un
-               BitStream  -/
-            for (i = 0; i < tabla[c].tamano; i++) {
-               int bit =  0 != (tabla[c].bits & (0x1<<i));
-               PutBit(out, bit);
-            }
-        
-        Puedes colocarlo en una funcion si quieres
 
-    */
+    // COMPRESION DEL TEXTO  ---------------------------------------
+    // buscar el campobits correspondiente en la tabla (indice = ascii del caracter) 
+    // y agregar el codigo entero de una vez, el primer bit de campobits es el primero en salir
+    for (i = 0; i < n; i++) {
+        campobits* b = &tabla[datos[i]];
+        PutBits(out, b->bits, b->tamano);
+    }
+    EST_ETAPA(EST_CODIFICAR, m);
 
-    /* No te olvides de limpiar */
-    if (in)
-        fclose(in);
-    if (out)
-        CloseBitStream(out);
-       
-    return 0;
+    return out->error;
 }
 
 /*
@@ -536,16 +1521,16 @@ static int codificar(Arbol T, char* entrada, char* salida) {
     Cuando encontramos una hoja, es un caracter,
     guardamos en el indice correspondiente a su num en ascii
 */
-static void crear_tabla(campobits* tabla, Arbol T, campobits* bits) {
+static void crear_tabla(campobits* tabla, const ArbolPlano* T, int nodo, campobits* bits) {
     CONFIRM_RETURN(T);
+    if (nodo < 0) return; // arbol vacio
 
     // si llegamos una hoja, guardamos el valor de 'bits' en la tabla
-    if (_es_hoja(T)) {
-        // obtener el valor del nodo
-        char* c = (char*)arbol_valor(T);
+    if (_es_hoja(T, nodo)) {
+        // el caracter esta en der
+        unsigned char c = (unsigned char)T->nodos[nodo].der;
         // guardamos en la tabla de campobits usando el valor en ascii del char como indice
-        tabla[*c] = *bits;
-        printf("se escribio codigo de %c", *c);
+        tabla[c] = *bits;
         return;
     }
 
@@ -555,12 +1540,12 @@ static void crear_tabla(campobits* tabla, Arbol T, campobits* bits) {
     // hacia la izquierda, agregando 0
     campobits izquierda = *bits; 
     bits_agregar(&izquierda, 0);
-    crear_tabla(tabla, arbol_izq(T), &izquierda);
+    crear_tabla(tabla, T, T->nodos[nodo].izq, &izquierda);
 
     // hacia la derecha, agregando 0
     campobits derecha = *bits;
     bits_agregar(&derecha, 1);
-    crear_tabla(tabla, arbol_der(T), &derecha);
+    crear_tabla(tabla, T, T->nodos[nodo].der, &derecha);
 }
 
              
@@ -579,134 +1564,3015 @@ static void crear_tabla(campobits* tabla, Arbol T, campobits* bits) {
    codigo ASCII. Hacemos esto hasta que todos los nodos tienen sus 
    hijos. (Si esta bien escrito el arbol el algoritmo terminara
    porque no hay mas nodos sin hijos)
+   Los nodos se agregan al arreglo plano T (ver _leer_nodo).
+   retorna 0 si no hay errores
 */
-static Arbol leer_arbol(BitStream bs) {
-    CONFIRM_NOTNULL(bs, NULL);
-    // leer un bit de bs
-    int bit = GetBit(bs);
-    // si el bit leido es una hoja debemos leer el ascii
-    if (bit == 1) {
-        char c = (char)GetByte(bs);
-        // creamos la hoja con el char como valor
-        return arbol_crear(c);
-    }
-    else if (bit == 0){
-        // leer recursivamente creando nodo izq y der
-        Arbol izq = leer_arbol(bs);
-        Arbol der = leer_arbol(bs);
-        // creamos el nodo interno que une ambos arboles
-        _crear_nodo_interno(izq, der);
-    }
-    else { // si hay un error de lectura
-        return NULL;
-    }
-
+static int leer_arbol(BitReader bs, ArbolPlano* T) {
+    CONFIRM_NOTNULL(bs, 1);
+    CONFIRM_NOTNULL(T, 1);
+    T->num = 0;
+    T->raiz = _leer_nodo(bs, T, 0);
+    return T->raiz < 0;
 }
 
 /* Esto se utiliza como parte de la descompresion (ver descomprimir())..
    
    Ahora lee todos los bits que quedan en in, y escribelos como bytes
-   en out. Utiliza los bits para navegar por el arbol de huffman, y
-   cuando llegues a una hoja escribe el codigo ASCII al out con PutByte()
-   y vuelve a comenzar a procesar bits desde la raiz.
+   en out. 
    
-   Sigue con este proceso hasta que no hay mas bits en in.
+   En vez de navegar el arbol bit por bit, se usa una tabla de
+   decodificacion (ver tabladec.h) con los codigos del arbol o de las
+   longitudes canonicas (ver tabla_desde_arbol/tabla_desde_longitudes). Se van
+   juntando los bits en un acumulador de 64 bits y con los siguientes
+   TABLADEC_BITS bits se busca en la tabla que caracter(es) corresponden
+   y cuantos bits consumir. Los codigos mas largos siguen en subtablas.
+   
+   Sigue con este proceso hasta decodificar los cuenta caracteres de la
+   cabecera, o si es -1 (archivos viejos) hasta que no hay mas bits en in.
+   En MODO_CONTEXTO t es NULL y se usan las tablas de contextos.
+   retorna 0 si no hay errores
 */   
-static void decodificar(BitStream in, BitStream out, Arbol arbol) {
-    CONFIRM_RETURN(arbol);
-    CONFIRM_RETURN(in);
-    CONFIRM_RETURN(out);
-    Arbol raiz = (Arbol)arbol;
+static int decodificar(BitReader in, FILE* out, TablaDec t, const TablasContexto* contextos, long long cuenta) {
+    CONFIRM_TRUE(t != NULL || contextos != NULL, 1);
+    CONFIRM_NOTNULL(in, 1);
+    CONFIRM_NOTNULL(out, 1);
+    // los caracteres decodificados se juntan en un buffer y se escriben de a bloques grandes
+    unsigned char* buffer = malloc(BITIO_BUFFER_SALIDA);
+    CONFIRM_NOTNULL(buffer, 1);
 
-    // mientras aun quedan bits en in
-    while (!IsEmptyBitStream(in)) {
-        // recorre hasta encontrar una hoja
-        // cuando encuentra la hoja escribe el caracter
-        // luego vuelve a recorrer desde la raiz
-        _recorrer(raiz, in, out);
+    int error = 0;
+    unsigned char anterior = 0; // el contexto sigue de un buffer al otro
+    EST_NUEVA_MARCA(m);
+    while (1) {
+        size_t pedir = BITIO_BUFFER_SALIDA;
+        if (cuenta >= 0 && (unsigned long long)cuenta < pedir) {
+            pedir = (size_t)cuenta;
+        }
+        size_t n = contextos != NULL ? decodificar_contexto(in, contextos, buffer, pedir, &anterior) : decodificar_memoria(in, t, buffer, pedir);
+        EST_ETAPA(EST_DECODIFICAR, m);
+        EST_CONTAR(simbolos, n);
+        EST_CONTAR(bytes_salida, n);
+        if (fwrite(buffer, 1, n, out) != n) {
+            error = 1;
+            break;
+        }
+        EST_ETAPA(EST_ENTRADA_SALIDA, m);
+        if (cuenta < 0) {
+            if (n < pedir) break; // se terminaron los bits
+            continue;
+        }
+        cuenta -= (long long)n;
+        if (n < pedir) error = 1; // faltan caracteres
+        if (cuenta == 0 || error) break;
     }
-   
+
+    free(buffer);
+    return error;
 }
-// recorre un arbol y si llega a una hoja pone el caracter en el archivo
-static void _recorrer(Arbol a, BitStream in, BitStream out) {
-    if (_es_hoja(a)) {
-        char c = (char)arbol_valor(a);
-        PutByte(out, c); // pone el caracter en el archivo de salida
-        return;
+
+/*
+  Un paso del ciclo rapido sobre un flujo (decodificar_memoria, decodificar_4): recarga
+  acc con una palabra entera (quedan al menos 8 bytes en p), busca en la tabla y escribe
+  1 o 2 caracteres. Hay lugar para 2 en d, el segundo se pisa despues si la entrada tiene uno solo.
+  El estado queda igual que con FillBits, se puede seguir con el lector.
+*/
+#define _PASO_RAPIDO(acc, n, p, d) do { \
+        if (n <= 56) { \
+            acc |= BITIO_LEER64(p) << n; \
+            p += (63 - n) >> 3; \
+            n |= 56; \
+        } \
+        EntradaDec e = entradas[acc & mascara]; \
+        int usados = 0; \
+        if (e.nsim == 0) { \
+            int u = 0; /* usados no se pasa por direccion, asi queda en un registro */ \
+            e = tabladec_subtabla(t, e, acc, &u); \
+            usados = u; \
+            if (e.nsim == 0) { \
+                error = 1; \
+                break; \
+            } \
+        } \
+        d[0] = (unsigned char)e.valor; \
+        d[1] = (unsigned char)(e.valor >> 16); \
+        d += e.nsim; \
+        acc >>= usados + e.bits; \
+        n -= usados + e.bits; \
+    } while (0)
+
+/*
+  Decodifica hasta max caracteres de in a destino usando la tabla.
+  Se detiene antes si se terminan los bits (o si el codigo es invalido).
+  Mientras queden bytes en el buffer de in y lugar en destino se usa el ciclo
+  rapido, sin revisar los limites en cada caracter (ver _vueltas_seguras);
+  el final se decodifica de a un codigo.
+  retorna la cantidad de caracteres decodificados
+*/
+static size_t decodificar_memoria(BitReader in, TablaDec t, unsigned char* destino, size_t max) {
+    unsigned long long mascara = (1u << t->bits_primaria) - 1;
+    const EntradaDec* entradas = t->entradas;
+    int bmax = t->max_longitud > t->bits_primaria ? t->max_longitud : t->bits_primaria;
+    size_t pos = 0;
+
+    while (pos < max) {
+        size_t vueltas = _vueltas_seguras(in->buf + in->pos, in->buf + in->tam, destino + pos, destino + max, bmax);
+        if (vueltas > 0) {
+            // el estado del lector en variables locales, asi queda en registros
+            unsigned long long acc = in->acc;
+            int n = in->n;
+            const unsigned char* p = in->buf + in->pos;
+            unsigned char* d = destino + pos;
+            int error = 0;
+            for (; vueltas > 0 && !error; vueltas--) {
+                _PASO_RAPIDO(acc, n, p, d);
+            }
+            in->acc = acc;
+            in->n = n;
+            in->pos = (size_t)(p - in->buf);
+            pos = (size_t)(d - destino);
+            if (error) {
+                break;
+            }
+            continue;
+        }
+
+        // llenar el acumulador con los bits que aun quedan en in
+        int n = FillBits(in);
+        unsigned long long acc = in->acc;
+        if (n == 0) {
+            break;
+        }
+
+        EntradaDec e = entradas[acc & mascara];
+        int usados = 0;
+        if (e.nsim == 0) { // codigo largo, seguir en las subtablas
+            e = tabladec_subtabla(t, e, acc, &usados);
+            if (e.nsim == 0) {
+                break;
+            }
+        }
+
+        int bits = usados + e.bits;
+        // si el segundo caracter no entra (final de los bits o del destino) se usa solo el primero
+        if (e.nsim == 2 && (bits > n || pos + 2 > max)) {
+            e.nsim = 1;
+            bits = e.bits1;
+        }
+        if (bits > n) {
+            break; // lo que queda es relleno
+        }
+
+        destino[pos++] = (unsigned char)e.valor;
+        if (e.nsim == 2) {
+            destino[pos++] = (unsigned char)(e.valor >> 16);
+        }
+        in->acc >>= bits;
+        in->n -= bits;
+    }
+    return pos;
+}
+
+/* Arma la tabla de decodificacion con los codigos del arbol reconstruido (MODO_ARBOL)
+si arena no es NULL la tabla sale de ahi */
+static TablaDec tabla_desde_arbol(const ArbolPlano* T, Arena arena) {
+    CONFIRM_NOTNULL(T, NULL);
+    campobits tabla[NUM_CHARS];
+    campobits bits = { 0, 0 };
+    unsigned int codigos[NUM_CHARS];
+    unsigned char longitudes[NUM_CHARS];
+    int i = 0;
+
+    // el arbol reconstruido da los mismos codigos que uso el compresor
+    memset(tabla, 0, NUM_CHARS * sizeof(struct _campobits));
+    crear_tabla(tabla, T, T->raiz, &bits);
+    for (i = 0; i < NUM_CHARS; i++) {
+        codigos[i] = tabla[i].bits;
+        longitudes[i] = (unsigned char)tabla[i].tamano;
+    }
+    return tabladec_crear_arena(codigos, longitudes, NUM_CHARS, TABLADEC_BITS, arena);
+}
+
+/* Lee las longitudes canonicas (MODO_CANONICO) y arma la tabla directamente, sin arbol
+si arena no es NULL la tabla sale de ahi */
+static TablaDec tabla_desde_longitudes(BitReader in, Arena arena) {
+    CONFIRM_NOTNULL(in, NULL);
+    unsigned int codigos[NUM_CHARS];
+    unsigned char longitudes[NUM_CHARS];
+
+    if (canonico_leer(in, longitudes, NUM_CHARS) != 0) return NULL;
+    if (canonico_codigos(longitudes, NUM_CHARS, codigos) != 0) return NULL;
+    return tabladec_crear_arena(codigos, longitudes, NUM_CHARS, TABLADEC_BITS, arena);
+}
+
+/*
+  Como tabla_desde_longitudes, pero si las longitudes son las mismas que las de
+  la tabla en cache la reusa sin armarla. Si no, vacia la arena, arma la tabla
+  ahi y la deja en cache. Los mensajes o bloques parecidos suelen repetir las longitudes.
+  retorna NULL si hubo error
+*/
+static TablaDec tabla_cacheada(BitReader in, CacheTabla* cache, Arena arena) {
+    unsigned int codigos[NUM_CHARS];
+    unsigned char longitudes[NUM_CHARS];
+
+    if (canonico_leer(in, longitudes, NUM_CHARS) != 0) return NULL;
+    if (cache->tabla != NULL && memcmp(longitudes, cache->longitudes, NUM_CHARS) == 0) {
+        return cache->tabla;
+    }
+    cache->tabla = NULL;
+    if (canonico_codigos(longitudes, NUM_CHARS, codigos) != 0) return NULL;
+    arena_vaciar(arena);
+    cache->tabla = tabladec_crear_arena(codigos, longitudes, NUM_CHARS, TABLADEC_BITS, arena);
+    memcpy(cache->longitudes, longitudes, NUM_CHARS);
+    return cache->tabla;
+}
+
+
+/*====================================================
+     Compresion por bloques (MODO_BLOQUES)
+  ====================================================*/
+
+/*
+  La entrada se lee una sola vez, de a bloques de op->tam_bloque bytes.
+  Cada bloque tiene sus propias frecuencias y longitudes canonicas
+  (crear_huffman_lineal, que es rapido y no imprime nada), asi los bloques
+  son independientes y se codifican en paralelo: se leen de a tandas de
+  BLOQUES_POR_HILO bloques por hilo, el pool los codifica y se escriben en
+  orden apenas termina la tanda. Leyendo de un archivo, un hilo lee la tanda
+  siguiente y otro escribe la anterior mientras el pool codifica (ver
+  tuberia_ejecutar). La memoria usada no depende del tamano del archivo.
+  Si recursos no es NULL la tanda (pool, trabajos y buffers) sale de ahi y queda
+  para la proxima llamada.
+  Si in es NULL los bloques se codifican directamente desde los tam_entrada bytes de entrada.
+
+  Formato:
+     byte MODO_BLOQUES
+     tam_bloque (4 bytes)
+     por cada bloque: tipo (1 byte), tamano original (4 bytes),
+                      tamano comprimido (4 bytes), cuerpo
+     un bloque BLOQUE_FIN
+     indice: por cada bloque tamano original y comprimido (4 bytes c/u),
+             cantidad de bloques (4 bytes), INDICE_MAGIA (4 bytes)
+  El cuerpo es la cabecera de canonico_escribir seguida de los codigos,
+  completado hasta el byte; si los codigos no ganan nada el bloque va sin
+  codificar (BLOQUE_CRUDO, o BLOQUE_RLE si es un solo caracter repetido, ver
+  elegir_tipo). El indice al final permite ubicar cualquier bloque sin
+  recorrer el archivo.
+
+  Retorna 0 si no hay errores.
+*/
+static int comprimir_bloques(FILE* in, const unsigned char* entrada, size_t tam_entrada, Salida* out, const OpcionesHuffman* op, Tanda* recursos) {
+    size_t tam_bloque = (size_t)op->tam_bloque;
+    size_t cap = cota_bloque(tam_bloque);
+    unsigned char cabecera[CABECERA_BLOQUE];
+    int error = 0;
+
+    // sin contexto la tanda es solo de esta llamada; leyendo de un archivo
+    // la lectura, la codificacion y la escritura se superponen
+    int ranuras = in != NULL ? RANURAS_TUBERIA : 1;
+    Tanda propia = { 0 };
+    Tanda* t = recursos != NULL ? recursos : &propia;
+    if (tanda_preparar(t, op->hilos, ranuras, in != NULL ? tam_bloque : 0, CABECERA_BLOQUE + cap) != 0) {
+        tanda_liberar(&propia);
+        return 1;
+    }
+    int num = t->num;
+    size_t paso = (CABECERA_BLOQUE + cap) * num + CABECERA_BLOQUE; /* cuerpos de una ranura */
+    for (int i = 0; i < num * ranuras; i++) {
+        TrabajoBloque* b = &t->trabajos[i];
+        b->datos = in != NULL ? t->datos + tam_bloque * i : NULL;
+        b->cuerpo = t->cuerpos + paso * (i / num) + (CABECERA_BLOQUE + cap) * (i % num) + CABECERA_BLOQUE;
+        b->cap = cap;
+        b->max_longitud = op->max_longitud;
+        b->flujos = op->flujos;
+    }
+
+    // cabecera del archivo
+    cabecera[0] = MODO_BLOQUES;
+    _poner_u32(cabecera + 1, (unsigned int)tam_bloque);
+    if (_escribir(out, cabecera, 5) != 0) error = 1;
+
+    // indice: tamano original y comprimido de cada bloque (lo arma el escritor)
+    Tuberia tb = { 0 };
+    tb.t = t;
+    tb.ranuras = ranuras;
+    tb.tam_bloque = tam_bloque;
+    tb.cap = cap;
+    tb.f = in;
+    tb.entrada = entrada;
+    tb.tam_entrada = tam_entrada;
+    tb.out = out;
+    if (!error) {
+        error = tuberia_ejecutar(&tb, _tarea_leer_bloques, _tarea_codificar, _tarea_escribir_bloques);
+    }
+    if (in != NULL) EST_CONTAR(bytes_entrada, tb.pos_entrada);
+    size_t num_bloques = tb.num_bloques;
+
+    // marca de fin e indice, armados de a pedazos en el stack
+    if (!error) {
+        unsigned char pie[4096];
+        memset(pie, 0, CABECERA_BLOQUE);
+        pie[0] = BLOQUE_FIN;
+        size_t usado = CABECERA_BLOQUE;
+        for (size_t i = 0; !error && i < 2 * num_bloques + 2; i++) {
+            unsigned int v = i < 2 * num_bloques ? t->indice[i] : i == 2 * num_bloques ? (unsigned int)num_bloques : INDICE_MAGIA;
+            if (usado + 4 > sizeof(pie)) {
+                error = _escribir(out, pie, usado) != 0;
+                usado = 0;
+            }
+            _poner_u32(pie + usado, v);
+            usado += 4;
+        }
+        if (!error && _escribir(out, pie, usado) != 0) error = 1;
+    }
+
+    tanda_liberar(&propia);
+    return error;
+}
+
+/*
+  Lee los bloques que siguen al byte de modo y los decodifica en paralelo,
+  de a tandas como en comprimir_bloques. Si el archivo permite moverse
+  (no es un pipe) se usa el indice del final para leer cada tanda de una sola vez.
+  Si in es un lector de memoria (archivo mapeado) los bloques se decodifican
+  desde ahi, sin copiarlos, y si out es de memoria se decodifican directamente
+  en su lugar. Si out es un archivo, la lectura, la decodificacion y la
+  escritura se superponen como en comprimir_bloques. El pool tiene hilos hilos
+  (0 = uno por procesador); si recursos no es NULL la tanda sale de ahi, como
+  en comprimir_bloques.
+
+  Retorna 0 si no hay errores.
+*/
+static int descomprimir_bloques(BitReader in, Salida* out, int hilos, Tanda* recursos) {
+    unsigned char cabecera[CABECERA_BLOQUE];
+    CONFIRM_TRUE(GetBytes(in, cabecera, 4) == 4, 1);
+    size_t tam_bloque = _leer_u32(cabecera);
+    CONFIRM_TRUE(tam_bloque > 0 && tam_bloque <= MAX_TAM_BLOQUE, 1);
+
+    size_t cap = cota_bloque(tam_bloque);
+    int en_memoria = in->f == NULL;
+
+    // sin contexto la tanda es solo de esta llamada
+    // (las tablas de cada lugar salen de la arena de su trabajo)
+    int ranuras = out->f != NULL ? RANURAS_TUBERIA : 1;
+    Tanda propia = { 0 };
+    Tanda* t = recursos != NULL ? recursos : &propia;
+    if (tanda_preparar(t, hilos, ranuras, out->f != NULL ? tam_bloque : 0, en_memoria ? 0 : CABECERA_BLOQUE + cap) != 0) {
+        tanda_liberar(&propia);
+        return 1;
+    }
+    Tuberia tb = { 0 };
+    tb.t = t;
+    tb.ranuras = ranuras;
+    tb.tam_bloque = tam_bloque;
+    tb.cap = cap;
+    tb.in = in;
+    tb.out = out;
+    tb.destino = out->pos;
+    tb.indice = leer_indice(in, t, &tb.num_indice);
+
+    int error = tuberia_ejecutar(&tb, _tarea_leer_cuerpos, _tarea_decodificar, _tarea_escribir_datos);
+    tanda_liberar(&propia);
+    return error;
+}
+
+/*
+  Hace pasar las tandas de tb por tres etapas: leer (en el lector de la tanda),
+  procesar los bloques en el pool y escribir (en el escritor). Con una ranura
+  cada etapa espera a la anterior. Con mas, mientras el pool procesa la tanda
+  de una ranura el lector llena la siguiente y el escritor vacia la anterior,
+  asi el disco y los procesadores trabajan a la vez. Una ranura se vuelve a
+  leer recien cuando termino de escribirse: si el disco o la codificacion se
+  atrasan la otra etapa espera y la memoria no pasa de las ranuras.
+  En las estadisticas, EST_ENTRADA_SALIDA es lo que se espera al lector y al escritor.
+
+  Retorna 0 si no hay errores.
+*/
+static int tuberia_ejecutar(Tuberia* tb, TareaHilos leer, TareaHilos procesar, TareaHilos escribir) {
+    Tanda* t = tb->t;
+    EST_NUEVA_MARCA(m);
+    ayudante_lanzar(t->lector, leer, tb, 0);
+    for (int k = 0; ; k++) {
+        int r = k % tb->ranuras;
+        ayudante_esperar(t->lector);
+        if (tb->error_lectura) break;
+        int fin = tb->fin[r];
+        // la ranura siguiente ya se escribio: al escritor se lo espero en la vuelta anterior
+        if (!fin && tb->ranuras > 1) ayudante_lanzar(t->lector, leer, tb, (k + 1) % tb->ranuras);
+        EST_ETAPA(EST_ENTRADA_SALIDA, m);
+
+        TrabajoBloque* tanda = t->trabajos + (size_t)r * t->num;
+        pool_ejecutar(t->pool, procesar, tanda, tb->bloques[r]);
+        EST_SUMAR_TANDA(tanda, tb->bloques[r]);
+        EST_MARCAR(m);
+
+        ayudante_esperar(t->escritor);
+        if (tb->error_escritura) break;
+        ayudante_lanzar(t->escritor, escribir, tb, r);
+        if (fin) break;
+        // con una sola ranura se lee despues de escribir
+        if (tb->ranuras == 1) ayudante_lanzar(t->lector, leer, tb, 0);
     }
-    else { 
-        // obtener un bit
-        int bit = GetBit(in);
-        if (bit == 0) { // si es 0, ir a la izquierda
-            _recorrer(arbol_izq(a), in, out);
+    ayudante_esperar(t->lector);
+    ayudante_esperar(t->escritor);
+    EST_ETAPA(EST_ENTRADA_SALIDA, m);
+    return tb->error_lectura || tb->error_escritura;
+}
+
+/* Etapa de lectura de comprimir_bloques: la ranura r recibe los siguientes
+bloques de la entrada (del archivo, o pedazos de la memoria sin copiarlos) */
+static void _tarea_leer_bloques(void* ctx, int r) {
+    Tuberia* tb = (Tuberia*)ctx;
+    TrabajoBloque* tanda = tb->t->trabajos + (size_t)r * tb->t->num;
+    int bloques = 0;
+    tb->fin[r] = 0;
+    while (bloques < tb->t->num) {
+        TrabajoBloque* b = &tanda[bloques];
+        if (tb->f == NULL) {
+            // el bloque es un pedazo de la entrada, solo se lee (codificar_bloque recibe const)
+            b->datos = (unsigned char*)tb->entrada + tb->pos_entrada;
+            b->n = tb->tam_entrada - tb->pos_entrada < tb->tam_bloque ? tb->tam_entrada - tb->pos_entrada : tb->tam_bloque;
+        }
+        else {
+            b->n = _leer_completo(tb->f, b->datos, tb->tam_bloque);
+        }
+        tb->pos_entrada += b->n;
+        if (b->n == 0) {
+            tb->fin[r] = 1;
+            break;
         }
-        if (bit == 1) { // si es 1 a la derecha
-            _recorrer(arbol_der(a), in, out);
+        bloques++;
+        if (b->n < tb->tam_bloque) {
+            tb->fin[r] = 1;
+            break;
         }
     }
-    
+    tb->bloques[r] = bloques;
+    if (tb->f != NULL && ferror(tb->f)) tb->error_lectura = 1;
 }
 
+/* Etapa de escritura de comprimir_bloques: escribe en orden los bloques
+codificados de la ranura r y agrega sus tamanos al indice */
+static void _tarea_escribir_bloques(void* ctx, int r) {
+    Tuberia* tb = (Tuberia*)ctx;
+    Tanda* t = tb->t;
+    TrabajoBloque* tanda = t->trabajos + (size_t)r * t->num;
+    for (int i = 0; i < tb->bloques[r]; i++) {
+        TrabajoBloque* b = &tanda[i];
+        if (b->error || _crecer((void**)&t->indice, &t->cap_indice, sizeof(unsigned int) * 2 * (tb->num_bloques + 1)) != 0) {
+            tb->error_escritura = 1;
+            return;
+        }
+        t->indice[2 * tb->num_bloques] = (unsigned int)b->n;
+        t->indice[2 * tb->num_bloques + 1] = (unsigned int)b->tam;
+        tb->num_bloques++;
+
+        unsigned char* h = b->cuerpo - CABECERA_BLOQUE;
+        h[0] = (unsigned char)b->tipo;
+        _poner_u32(h + 1, (unsigned int)b->n);
+        _poner_u32(h + 5, (unsigned int)b->tam);
+        if (_escribir(tb->out, h, CABECERA_BLOQUE + b->tam) != 0) {
+            tb->error_escritura = 1;
+            return;
+        }
+    }
+    // la tanda sale apenas esta lista (para pipes y sockets)
+    if (tb->out->f != NULL && fflush(tb->out->f) != 0) tb->error_escritura = 1;
+}
 
-/* Esto es para imprimir nodos..
-   Tal vez tengas mas de uno de estas funciones debendiendo
-   de como decidiste representar los valores del arbol durante
-   la compresion y descompresion.
+/*
+  Etapa de lectura de descomprimir_bloques: separa los siguientes bloques del
+  archivo comprimido en la ranura r. Con el indice se sabe cuanto ocupa la
+  tanda y se lee de una vez (en memoria se usa desde ahi); si no, bloque por
+  bloque hasta la marca de fin.
 */
-static void imprimirNodo(Arbol nodo) {
-    CONFIRM_RETURN(nodo);
-    // Si es una hoja (sin hijos)
-    if (arbol_izq(nodo) == NULL && arbol_der(nodo) == NULL) {
-        char* c = (char*)arbol_valor(nodo);
-        printf("'%c'", *c);  // Muestra el carcter
+static void _tarea_leer_cuerpos(void* ctx, int r) {
+    Tuberia* tb = (Tuberia*)ctx;
+    Tanda* t = tb->t;
+    BitReader in = tb->in;
+    Salida* out = tb->out;
+    const unsigned int* indice = tb->indice;
+    int num = t->num;
+    int en_memoria = in->f == NULL;
+    size_t cap = tb->cap;
+    TrabajoBloque* tanda = t->trabajos + (size_t)r * num;
+    // la parte de los buffers de la ranura (solo existen si se usan)
+    unsigned char* datos = out->f != NULL ? t->datos + tb->tam_bloque * num * r : NULL;
+    unsigned char* cuerpos = !en_memoria ? t->cuerpos + ((CABECERA_BLOQUE + cap) * num + CABECERA_BLOQUE) * r : NULL;
+    int bloques = 0;
+    int error = 0;
+    tb->fin[r] = 0;
+    tb->bloques[r] = 0;
+
+    unsigned char* inicio = cuerpos;
+    if (indice != NULL) {
+        // con el indice se sabe cuanto ocupa la tanda (bloques + BLOQUE_FIN al final)
+        size_t total = 0;
+        while (bloques < num && tb->leidos + bloques < tb->num_indice) {
+            if (indice[2 * (tb->leidos + bloques) + 1] > cap) {
+                tb->error_lectura = 1;
+                return;
+            }
+            total += CABECERA_BLOQUE + indice[2 * (tb->leidos + bloques) + 1];
+            bloques++;
+        }
+        if (tb->leidos + bloques == tb->num_indice) {
+            total += CABECERA_BLOQUE;
+        }
+        if (en_memoria) {
+            // la tanda se usa desde el mapeo (solo se lee)
+            inicio = (unsigned char*)GetBytesMem(in, total);
+            error = inicio == NULL;
+        }
+        else {
+            error = GetBytes(in, cuerpos, total) != total;
+        }
+        if (error) {
+            tb->error_lectura = 1;
+            return;
+        }
+    }
+
+    // separar los bloques de la tanda
+    unsigned char* p = inicio;
+    int i = 0;
+    while (!error && i < num) {
+        if (indice != NULL && i == bloques) {
+            break;
+        }
+        if (indice == NULL) {
+            const unsigned char* h = en_memoria ? GetBytesMem(in, CABECERA_BLOQUE) : NULL;
+            if (en_memoria && h != NULL) {
+                p = (unsigned char*)h;
+            }
+            else if (en_memoria || GetBytes(in, p, CABECERA_BLOQUE) != CABECERA_BLOQUE) {
+                error = 1; // falta la marca de fin
+                break;
+            }
+        }
+        if (p[0] == BLOQUE_FIN) {
+            tb->fin[r] = 1;
+            break;
+        }
+        TrabajoBloque* b = &tanda[i];
+        b->n = _leer_u32(p + 1);
+        b->tam = _leer_u32(p + 5);
+        b->cuerpo = p + CABECERA_BLOQUE;
+        b->tipo = p[0];
+        if (!BLOQUE_VALIDO(p[0]) || b->n > tb->tam_bloque || b->tam > cap) {
+            error = 1;
+            break;
+        }
+        if (out->f != NULL) {
+            b->datos = datos + tb->tam_bloque * i;
+        }
+        else if (b->n <= out->cap - tb->destino) {
+            // en memoria cada bloque se decodifica en su lugar final
+            b->datos = out->buf + tb->destino;
+            tb->destino += b->n;
+        }
+        else {
+            error = 1; // no entra en la salida
+            break;
+        }
+        if (indice != NULL) {
+            if (b->n != indice[2 * (tb->leidos + i)] || b->tam != indice[2 * (tb->leidos + i) + 1]) error = 1;
+        }
+        else if (en_memoria) {
+            b->cuerpo = (unsigned char*)GetBytesMem(in, b->tam);
+            if (b->cuerpo == NULL) error = 1;
+        }
+        else if (GetBytes(in, b->cuerpo, b->tam) != b->tam) {
+            error = 1;
+        }
+        if (indice != NULL) p = b->cuerpo + b->tam;
+        else if (!en_memoria) p += CABECERA_BLOQUE + cap;
+        i++;
+    }
+    if (indice != NULL && !error) {
+        // la ultima tanda termina con la marca de fin
+        if (i < bloques) error = 1;
+        else if (tb->leidos + bloques == tb->num_indice) {
+            if (p[0] != BLOQUE_FIN) error = 1;
+            tb->fin[r] = 1;
+        }
     }
-    else { // si es un nodo interno 
-        int* freq = (int*)arbol_valor(nodo);
-        printf("%d", *freq);  // Muestra la suma de frecuencias
+    if (error) {
+        tb->error_lectura = 1;
+        return;
     }
+    tb->bloques[r] = i;
+    tb->leidos += i;
 }
 
-// imprimir nodo del arbol reconstruido
-// en este caso, ya no tenemos valores en os nodos internos, asi que imprimimos un * 
-static void imprimirNodoReconstruido(Arbol nodo) {
-    CONFIRM_RETURN(nodo);
-    // Si es una hoja (sin hijos)
-    if (arbol_izq(nodo) == NULL && arbol_der(nodo) == NULL) {
-        char c = (char)arbol_valor(nodo);
-        printf("'%c'", c);  // Muestra el carcter
+/* Etapa de escritura de descomprimir_bloques: escribe en orden los bloques
+decodificados de la ranura r (en memoria ya estan en su lugar, solo avanza la posicion) */
+static void _tarea_escribir_datos(void* ctx, int r) {
+    Tuberia* tb = (Tuberia*)ctx;
+    TrabajoBloque* tanda = tb->t->trabajos + (size_t)r * tb->t->num;
+    for (int i = 0; i < tb->bloques[r]; i++) {
+        if (tanda[i].error || _escribir(tb->out, tanda[i].datos, tanda[i].n) != 0) {
+            tb->error_escritura = 1;
+            return;
+        }
+    }
+}
+
+/*
+  Version secuencial de comprimir_bloques para comprimir_memoria: los bloques se
+  codifican en este hilo directamente en salida y la memoria de trabajo sale de
+  la arena (que se vacia en cada bloque). El resultado es el mismo archivo.
+
+  retorna el tamano del resultado, -1 si hubo error o no entra en cap
+*/
+static long long comprimir_bloques_memoria(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap, const OpcionesHuffman* op, Arena arena) {
+    size_t tam_bloque = (size_t)op->tam_bloque;
+    size_t num_bloques = 0;
+    size_t pos = 5;
+    CONFIRM_TRUE(cap >= pos, -1);
+
+    // cabecera del archivo
+    salida[0] = MODO_BLOQUES;
+    _poner_u32(salida + 1, (unsigned int)tam_bloque);
+
+    for (size_t inicio = 0; inicio < n; inicio += tam_bloque) {
+        size_t k = n - inicio < tam_bloque ? n - inicio : tam_bloque;
+        CONFIRM_TRUE(cap - pos > CABECERA_BLOQUE, -1);
+        arena_vaciar(arena);
+        unsigned char* h = salida + pos;
+        int tipo = BLOQUE_HUFFMAN;
+        long long tam = codificar_bloque(datos + inicio, k, h + CABECERA_BLOQUE, cap - pos - CABECERA_BLOQUE, op->max_longitud, op->flujos, &tipo, arena);
+        CONFIRM_TRUE(tam >= 0, -1);
+        h[0] = (unsigned char)tipo;
+        _poner_u32(h + 1, (unsigned int)k);
+        _poner_u32(h + 5, (unsigned int)tam);
+        pos += CABECERA_BLOQUE + (size_t)tam;
+        num_bloques++;
     }
-    else { // si es un nodo interno mostrar *
-        printf("*");  
+
+    // marca de fin e indice, copiado de las cabeceras de los bloques ya escritos
+    size_t tam_pie = CABECERA_BLOQUE + 8 * num_bloques + 8;
+    CONFIRM_TRUE(cap - pos >= tam_pie, -1);
+    unsigned char* pie = salida + pos;
+    memset(pie, 0, CABECERA_BLOQUE);
+    pie[0] = BLOQUE_FIN;
+    const unsigned char* h = salida + 5;
+    for (size_t i = 0; i < num_bloques; i++) {
+        memcpy(pie + CABECERA_BLOQUE + 8 * i, h + 1, 8);
+        h += CABECERA_BLOQUE + _leer_u32(h + 5);
     }
+    _poner_u32(pie + tam_pie - 8, (unsigned int)num_bloques);
+    _poner_u32(pie + tam_pie - 4, INDICE_MAGIA);
+    return (long long)(pos + tam_pie);
 }
 
-static int _es_hoja(Arbol nodo) {
-    CONFIRM_NOTNULL(nodo, -1);
-    return (arbol_izq(nodo) == NULL && arbol_der(nodo) == NULL);
+/*
+  Version secuencial de descomprimir_bloques para descomprimir_memoria: recorre
+  las cabeceras de los bloques sin copiar nada y decodifica cada uno directamente
+  en salida. Las tablas salen de la arena y se reusan si el bloque trae las
+  mismas longitudes que el anterior (ver tabla_cacheada).
+
+  retorna el tamano descomprimido, -1 si hubo error o no entra en cap
+*/
+static long long descomprimir_bloques_memoria(BitReader in, unsigned char* salida, size_t cap, CacheTabla* cache, Arena arena) {
+    const unsigned char* p = GetBytesMem(in, 4);
+    CONFIRM_NOTNULL(p, -1);
+    size_t tam_bloque = _leer_u32(p);
+    CONFIRM_TRUE(tam_bloque > 0 && tam_bloque <= MAX_TAM_BLOQUE, -1);
+    size_t pos = 0;
+
+    while (1) {
+        const unsigned char* h = GetBytesMem(in, CABECERA_BLOQUE);
+        if (h == NULL) break; // falta la marca de fin
+        if (h[0] == BLOQUE_FIN) return (long long)pos;
+        size_t n = _leer_u32(h + 1);
+        size_t tam = _leer_u32(h + 5);
+        if (!BLOQUE_VALIDO(h[0]) || n > tam_bloque || n > cap - pos) break;
+        const unsigned char* cuerpo = GetBytesMem(in, tam);
+        if (cuerpo == NULL) break;
+        if (decodificar_bloque(cuerpo, tam, salida + pos, n, h[0], cache, arena) != 0) break;
+        pos += n;
+    }
+    return -1;
 }
 
-static void _escribir_arbol(Arbol a, BitStream out) {
-    CONFIRM_RETURN(a);
-    CONFIRM_RETURN(out);
-    // si el nodo es una hoja ponemos un 1 y el byte del caracter
-    if (_es_hoja(a)) {
-        PutBit(out, 1);
-        char* c = (char*)arbol_valor(a);
-        PutByte(out, *c);
+/*
+  Deja la tanda lista para usar: crea el pool (de hilos hilos) la primera vez,
+  los trabajos con sus arenas de cada ranura (con mas de una, tambien los
+  ayudantes que leen y escriben), y agranda los buffers de datos y cuerpos para
+  tam_datos y tam_cuerpo bytes por lugar (mas una cabecera de bloque al final
+  de cada ranura).
+  retorna 0 si no hay errores
+*/
+static int tanda_preparar(Tanda* t, int hilos, int ranuras, size_t tam_datos, size_t tam_cuerpo) {
+    if (t->pool == NULL) {
+        t->pool = pool_crear(hilos);
+        if (t->pool == NULL) return 1;
+        t->num = pool_tamano(t->pool) * BLOQUES_POR_HILO;
+    }
+    if (ranuras > t->ranuras) {
+        // los trabajos de las ranuras nuevas, cada uno con su arena
+        TrabajoBloque* trabajos = (TrabajoBloque*)realloc(t->trabajos, sizeof(TrabajoBloque) * t->num * ranuras);
+        if (trabajos == NULL) {
+            tanda_liberar(t);
+            return 1;
+        }
+        memset(trabajos + t->num * t->ranuras, 0, sizeof(TrabajoBloque) * t->num * (ranuras - t->ranuras));
+        t->trabajos = trabajos;
+        t->ranuras = ranuras;
+        for (int i = 0; i < t->num * t->ranuras; i++) {
+            if (t->trabajos[i].arena == NULL) t->trabajos[i].arena = arena_crear(0);
+            if (t->trabajos[i].arena == NULL) {
+                tanda_liberar(t);
+                return 1;
+            }
+        }
     }
-    else { // si no ponemos un 0 
-        PutBit(out, 0);
+    if (ranuras > 1 && t->lector == NULL) {
+        // si no se pueden crear, las etapas se hacen en el hilo que llama
+        t->lector = ayudante_crear();
+        t->escritor = ayudante_crear();
     }
+    if (_crecer((void**)&t->datos, &t->cap_datos, tam_datos * t->num * ranuras) != 0) return 1;
+    if (tam_cuerpo > 0 && _crecer((void**)&t->cuerpos, &t->cap_cuerpos, (tam_cuerpo * t->num + CABECERA_BLOQUE) * ranuras) != 0) return 1;
+    return 0;
 }
 
-// funcion usada para reconstruir el arbol
-// crea un nodo sin valor, con hijo izq y derecho
-static Arbol _crear_nodo_interno(Arbol izq, Arbol der) {
-    CONFIRM_NOTNULL(izq, NULL);
-    CONFIRM_NOTNULL(der, NULL);
-    Arbol a = arbol_crear(NULL);
-    arbol_agregarIzq(a, izq);
-    arbol_agregarDer(a, der);
+/* Termina el pool y los ayudantes y libera todo lo de la tanda (queda vacia, como recien declarada) */
+static void tanda_liberar(Tanda* t) {
+    ayudante_destruir(t->lector);
+    ayudante_destruir(t->escritor);
+    pool_destruir(t->pool);
+    for (int i = 0; t->trabajos != NULL && i < t->num * t->ranuras; i++) {
+        arena_destruir(t->trabajos[i].arena);
+    }
+    free(t->trabajos);
+    free(t->datos);
+    free(t->cuerpos);
+    free(t->indice);
+    memset(t, 0, sizeof(Tanda));
+}
+
+/* Tarea del pool: codifica el bloque i de la tanda */
+static void _tarea_codificar(void* ctx, int i) {
+    TrabajoBloque* b = (TrabajoBloque*)ctx + i;
+    EST_TRABAJO(b);
+    // lo que pidio el bloque anterior de este lugar se libera de una vez
+    arena_vaciar(b->arena);
+    long long tam = codificar_bloque(b->datos, b->n, b->cuerpo, b->cap, b->max_longitud, b->flujos, &b->tipo, b->arena);
+    b->error = tam < 0;
+    b->tam = tam < 0 ? 0 : (size_t)tam;
+    EST_FIN_TRABAJO(b);
+}
+
+/* Tarea del pool: decodifica el bloque i de la tanda */
+static void _tarea_decodificar(void* ctx, int i) {
+    TrabajoBloque* b = (TrabajoBloque*)ctx + i;
+    EST_TRABAJO(b);
+    b->error = decodificar_bloque(b->cuerpo, b->tam, b->datos, b->n, b->tipo, &b->cache, b->arena);
+    EST_FIN_TRABAJO(b);
+}
+
+/*
+  Lee el indice de bloques del final del archivo sin mover la posicion de lectura.
+  retorna los pares (tamano original, tamano comprimido) de cada bloque, en el
+  indice de la tanda; NULL si el archivo no permite moverse (pipe) o no tiene indice
+*/
+static unsigned int* leer_indice(BitReader in, Tanda* t, unsigned int* num_bloques) {
+    unsigned char pie[8];
+    unsigned int* indice = NULL;
+    unsigned int num = 0;
+
+    if (in->f == NULL) {
+        // en memoria el indice esta al final del bloque de datos
+        if (in->tam < 8 || _leer_u32(in->buf + in->tam - 4) != INDICE_MAGIA) return NULL;
+        num = _leer_u32(in->buf + in->tam - 8);
+        if ((unsigned long long)num * 8 > in->tam - 8) return NULL;
+        const unsigned char* p = in->buf + in->tam - 8 - (size_t)num * 8;
+        if (_crecer((void**)&t->indice, &t->cap_indice, sizeof(unsigned int) * 2 * ((size_t)num + 1)) != 0) return NULL;
+        indice = t->indice;
+        for (unsigned int i = 0; i < 2 * num; i++) {
+            indice[i] = _leer_u32(p + 4 * (size_t)i);
+        }
+        *num_bloques = num;
+        return indice;
+    }
+
+    long pos = ftell(in->f);
+    if (pos < 0 || fseek(in->f, -8, SEEK_END) != 0) return NULL;
+    long fin = ftell(in->f);
+    if (fread(pie, 1, 8, in->f) == 8 && _leer_u32(pie + 4) == INDICE_MAGIA) {
+        num = _leer_u32(pie);
+        if ((long long)num * 8 <= fin && fseek(in->f, -8 - (long)num * 8, SEEK_END) == 0 &&
+            _crecer((void**)&t->indice, &t->cap_indice, sizeof(unsigned int) * 2 * ((size_t)num + 1)) == 0) {
+            indice = t->indice;
+            for (unsigned int i = 0; indice != NULL && i < 2 * num; i++) {
+                if (fread(pie, 1, 4, in->f) != 4) {
+                    indice = NULL;
+                    break;
+                }
+                indice[i] = _leer_u32(pie);
+            }
+            *num_bloques = num;
+        }
+    }
+    if (fseek(in->f, pos, SEEK_SET) != 0) {
+        return NULL;
+    }
+    return indice;
+}
+
+/*
+  Codifica los n bytes de datos en salida (de cap bytes): longitudes canonicas + codigos.
+  Con flujos == 4 los datos se parten en 4 cuartos consecutivos y cada uno va en
+  su propio flujo de bits, empezando en un byte: despues de las longitudes van
+  los tamanos de los 3 primeros flujos (SALTOS_FLUJOS) y los 4 flujos seguidos.
+  Asi el decodificador puede seguir los 4 flujos a la vez (ver decodificar_4).
+  Antes de armar el codigo se mira el histograma (elegir_tipo): un solo caracter
+  va como BLOQUE_RLE y si los codigos no pueden ocupar menos que los datos, o
+  con las longitudes ya armadas no ocupan menos, el bloque va como BLOQUE_CRUDO.
+  En *tipo queda el tipo del bloque.
+  retorna el tamano del bloque codificado, -1 si hubo error
+*/
+static long long codificar_bloque(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap, int max_longitud, int flujos, int* tipo, Arena arena) {
+    unsigned long long frecuencias[NUM_CHARS] = { 0 };
+    int profundidad[NUM_CHARS];
+    unsigned char longitudes[NUM_CHARS];
+    unsigned int codigos[NUM_CHARS];
+    size_t i = 0;
+
+    EST_NUEVA_MARCA(m);
+    histograma_contar(datos, n, frecuencias);
+    EST_ETAPA(EST_HISTOGRAMA, m);
+
+    *tipo = elegir_tipo(frecuencias, n);
+    if (*tipo == BLOQUE_HUFFMAN) {
+        int limite = max_longitud > 0 ? max_longitud : CANONICO_MAX_LONGITUD;
+        int maxima = crear_huffman_lineal(frecuencias, NUM_CHARS, profundidad, arena);
+        CONFIRM_TRUE(maxima >= 0, -1);
+        for (i = 0; i < NUM_CHARS; i++) {
+            longitudes[i] = (unsigned char)profundidad[i];
+        }
+        if (maxima > limite) {
+            CONFIRM_TRUE(0 == crear_huffman_limitado(frecuencias, NUM_CHARS, limite, longitudes, arena), -1);
+        }
+        // el tamano exacto: cabecera, codigos, relleno y saltos de los flujos
+        unsigned long long bits = _bits_cabecera(longitudes) + _costo_tabla(frecuencias, longitudes);
+        unsigned long long tam = (bits + 7) / 8 + (flujos == 4 ? SALTOS_FLUJOS + 4 : 0);
+        if (tam >= n) *tipo = BLOQUE_CRUDO;
+        EST_ETAPA(EST_ARBOL, m);
+    }
+    if (*tipo != BLOQUE_HUFFMAN) {
+        // sin codigos: el caracter repetido o los datos tal cual
+        size_t tam = *tipo == BLOQUE_RLE ? 1 : n;
+        CONFIRM_TRUE(tam <= cap, -1);
+        memcpy(salida, datos, tam);
+        EST_ETAPA(EST_CODIFICAR, m);
+        EST_CONTAR(bits_codigos, *tipo == BLOQUE_RLE ? 0 : 8 * (unsigned long long)n);
+        EST_CONTAR(bits_sin_limite, *tipo == BLOQUE_RLE ? 0 : 8 * (unsigned long long)n);
+        EST_CONTAR(simbolos, n);
+        EST_CONTAR(bloques, 1);
+        return (long long)tam;
+    }
+    *tipo = flujos == 4 ? BLOQUE_HUFFMAN4 : BLOQUE_HUFFMAN;
+    CONFIRM_TRUE(0 == canonico_codigos(longitudes, NUM_CHARS, codigos), -1);
+    EST_ETAPA(EST_TABLA, m);
+#ifndef HUFFMAN_SIN_ESTADISTICAS
+    if (_est != NULL) {
+        for (i = 0; i < NUM_CHARS; i++) {
+            _est->bits_codigos += frecuencias[i] * longitudes[i];
+            _est->bits_sin_limite += frecuencias[i] * profundidad[i];
+            if (longitudes[i] > _est->profundidad) _est->profundidad = longitudes[i];
+        }
+        _est->simbolos += n;
+        _est->bloques++;
+    }
+#endif
+
+    // el escritor va en el stack, codificar un bloque no pide memoria
+    struct _BitWriter escritor;
+    BitWriter bw = &escritor;
+    InitBitWriterMem(bw, salida, cap);
+    canonico_escribir(bw, longitudes, NUM_CHARS);
+    if (flujos == 1) {
+        for (i = 0; i < n; i++) {
+            unsigned char c = datos[i];
+            PutBits(bw, codigos[c], longitudes[c]);
+        }
+        long long tam = FlushBitWriterMem(bw);
+        EST_ETAPA(EST_CODIFICAR, m);
+        return tam;
+    }
+
+    // cabecera, lugar para los saltos y cada flujo completado hasta el byte
+    long long tam = FlushBitWriterMem(bw);
+    CONFIRM_TRUE(tam >= 0 && (size_t)tam + SALTOS_FLUJOS <= cap, -1);
+    unsigned char* saltos = salida + tam;
+    tam += SALTOS_FLUJOS;
+    size_t cuenta[4];
+    _partir_4(n, cuenta);
+    for (int k = 0; k < 4; k++) {
+        InitBitWriterMem(bw, salida + tam, cap - (size_t)tam);
+        for (i = 0; i < cuenta[k]; i++) {
+            unsigned char c = *datos++;
+            PutBits(bw, codigos[c], longitudes[c]);
+        }
+        long long tam_flujo = FlushBitWriterMem(bw);
+        CONFIRM_TRUE(tam_flujo >= 0, -1);
+        if (k < 3) _poner_u32(saltos + 4 * k, (unsigned int)tam_flujo);
+        tam += tam_flujo;
+    }
+    EST_ETAPA(EST_CODIFICAR, m);
+    return tam;
+}
+
+/*
+  Decodifica un bloque de tam bytes del tipo dado en exactamente n caracteres.
+  La tabla sale de la arena, o de cache si el bloque trae las mismas longitudes.
+  BLOQUE_CRUDO y BLOQUE_RLE no tienen tabla, se copian con memcpy o memset.
+  Retorna 0 si no hay errores.
+*/
+static int decodificar_bloque(const unsigned char* cuerpo, size_t tam, unsigned char* destino, size_t n, int tipo, CacheTabla* cache, Arena arena) {
+    struct _BitReader lector;
+    BitReader br = &lector;
+    InitBitReaderMem(br, cuerpo, tam);
+    EST_NUEVA_MARCA(m);
+    if (tipo == BLOQUE_CRUDO || tipo == BLOQUE_RLE) {
+        if (tam != (tipo == BLOQUE_RLE ? 1 : n)) return 1;
+        if (tipo == BLOQUE_RLE) memset(destino, cuerpo[0], n);
+        else memcpy(destino, cuerpo, n);
+        EST_ETAPA(EST_DECODIFICAR, m);
+        EST_CONTAR(simbolos, n);
+        EST_CONTAR(bloques, 1);
+        return 0;
+    }
+    TablaDec t = tabla_cacheada(br, cache, arena);
+    if (t == NULL) {
+        return 1;
+    }
+    EST_ETAPA(EST_TABLA, m);
+    int error = 0;
+    if (tipo == BLOQUE_HUFFMAN4) {
+        // los flujos empiezan en el byte que sigue a las longitudes
+        const unsigned char* resto = GetBytesMem(br, 0);
+        error = resto == NULL || decodificar_4(resto, tam - (size_t)(resto - cuerpo), t, destino, n) != 0;
+    }
+    else {
+        error = decodificar_memoria(br, t, destino, n) != n;
+    }
+    EST_ETAPA(EST_DECODIFICAR, m);
+    EST_CONTAR(simbolos, n);
+    EST_CONTAR(bloques, 1);
+    return error;
+}
+
+/*
+  Decodifica los 4 flujos de un BLOQUE_HUFFMAN4 (sin las longitudes) en n caracteres.
+
+  En un solo flujo cada busqueda en la tabla depende de los bits que consumio
+  la anterior. Con 4 flujos independientes el ciclo principal hace una busqueda
+  de cada uno por vuelta y el procesador las puede superponer. El ciclo rapido
+  trabaja con copias locales de los lectores y corre mientras a todos les
+  queden bytes y lugar para 2 caracteres (sin revisarlo en cada vuelta, ver
+  _vueltas_seguras); lo que falta al final de cada flujo se termina con
+  decodificar_memoria.
+
+  Retorna 0 si no hay errores.
+*/
+static int decodificar_4(const unsigned char* cuerpo, size_t tam, TablaDec t, unsigned char* destino, size_t n) {
+    CONFIRM_TRUE(tam >= SALTOS_FLUJOS, 1);
+    size_t cuenta[4];
+    size_t tam_flujo[4];
+    _partir_4(n, cuenta);
+
+    // ubicar los flujos con los saltos
+    size_t total = SALTOS_FLUJOS;
+    for (int k = 0; k < 3; k++) {
+        tam_flujo[k] = _leer_u32(cuerpo + 4 * k);
+        total += tam_flujo[k];
+        CONFIRM_TRUE(total <= tam, 1);
+    }
+    tam_flujo[3] = tam - total;
+
+    struct _BitReader r[4];
+    unsigned char* dst[4];
+    unsigned char* fin[4];
+    const unsigned char* p = cuerpo + SALTOS_FLUJOS;
+    unsigned char* q = destino;
+    for (int k = 0; k < 4; k++) {
+        InitBitReaderMem(&r[k], p, tam_flujo[k]);
+        dst[k] = q;
+        fin[k] = q + cuenta[k];
+        p += tam_flujo[k];
+        q += cuenta[k];
+    }
+
+    // el estado de cada flujo en variables locales, asi queda en registros
+    // (con los campos de r[k] el compilador los relee despues de cada byte escrito)
+    unsigned long long mascara = (1u << t->bits_primaria) - 1;
+    const EntradaDec* entradas = t->entradas;
+    unsigned long long acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    int n0 = 0, n1 = 0, n2 = 0, n3 = 0;
+    const unsigned char* p0 = r[0].buf;
+    const unsigned char* p1 = r[1].buf;
+    const unsigned char* p2 = r[2].buf;
+    const unsigned char* p3 = r[3].buf;
+    unsigned char* d0 = dst[0];
+    unsigned char* d1 = dst[1];
+    unsigned char* d2 = dst[2];
+    unsigned char* d3 = dst[3];
+    int error = 0;
+    // bits que puede consumir una vuelta como maximo (un par usa hasta bits_primaria)
+    int bmax = t->max_longitud > t->bits_primaria ? t->max_longitud : t->bits_primaria;
+    while (!error) {
+        // cuantas vueltas se pueden dar sin revisar los limites de ningun flujo
+        size_t vueltas = _vueltas_seguras(p0, r[0].buf + r[0].tam, d0, fin[0], bmax);
+        size_t v = _vueltas_seguras(p1, r[1].buf + r[1].tam, d1, fin[1], bmax);
+        if (v < vueltas) vueltas = v;
+        v = _vueltas_seguras(p2, r[2].buf + r[2].tam, d2, fin[2], bmax);
+        if (v < vueltas) vueltas = v;
+        v = _vueltas_seguras(p3, r[3].buf + r[3].tam, d3, fin[3], bmax);
+        if (v < vueltas) vueltas = v;
+        if (vueltas == 0) break;
+
+        for (; vueltas > 0 && !error; vueltas--) {
+            _PASO_RAPIDO(acc0, n0, p0, d0);
+            _PASO_RAPIDO(acc1, n1, p1, d1);
+            _PASO_RAPIDO(acc2, n2, p2, d2);
+            _PASO_RAPIDO(acc3, n3, p3, d3);
+        }
+    }
+    if (error) return 1;
+
+    // devolver el estado a los lectores
+    r[0].acc = acc0; r[0].n = n0; r[0].pos = (size_t)(p0 - r[0].buf); dst[0] = d0;
+    r[1].acc = acc1; r[1].n = n1; r[1].pos = (size_t)(p1 - r[1].buf); dst[1] = d1;
+    r[2].acc = acc2; r[2].n = n2; r[2].pos = (size_t)(p2 - r[2].buf); dst[2] = d2;
+    r[3].acc = acc3; r[3].n = n3; r[3].pos = (size_t)(p3 - r[3].buf); dst[3] = d3;
+
+    // el final de cada flujo
+    for (int k = 0; k < 4; k++) {
+        size_t falta = (size_t)(fin[k] - dst[k]);
+        if (decodificar_memoria(&r[k], t, dst[k], falta) != falta) return 1;
+    }
+    return 0;
+}
+
+/*
+  Cuantas vueltas del ciclo rapido (_PASO_RAPIDO) se pueden dar en un flujo sin pasarse:
+  cada vuelta consume a lo sumo bmax bits y escribe a lo sumo 2 caracteres, y cada
+  recarga lee 8 bytes desde una posicion a lo sumo 8 bytes por delante de lo consumido.
+*/
+static size_t _vueltas_seguras(const unsigned char* p, const unsigned char* fin_p, const unsigned char* d, const unsigned char* fin_d, int bmax) {
+    if (fin_p - p < 16 || fin_d - d < 2) return 0;
+    size_t por_bits = (size_t)(fin_p - p - 16) * 8 / (size_t)bmax;
+    size_t por_lugar = (size_t)(fin_d - d) / 2;
+    return por_bits < por_lugar ? por_bits : por_lugar;
+}
+
+/* Cantidad de caracteres de cada uno de los 4 flujos: cuartos redondeados hacia arriba, el ultimo lleva el resto */
+static void _partir_4(size_t n, size_t* cuenta) {
+    size_t cuarto = (n + 3) / 4;
+    for (int k = 0; k < 3; k++) {
+        cuenta[k] = cuarto < n ? cuarto : n;
+        n -= cuenta[k];
+    }
+    cuenta[3] = n;
+}
+
+/* Tamano maximo del cuerpo de un bloque de n bytes:
+   la cabecera de longitudes, los codigos (un codigo de huffman, limitado o no,
+   nunca ocupa mas que 8 bits por caracter) y los saltos y el relleno de 4 flujos */
+static size_t cota_bloque(size_t n) {
+    return MAX_CABECERA + n + 8 + SALTOS_FLUJOS + 4;
+}
+
+/*====================================================
+     Datos sin codigos (MODO_CRUDO, MODO_RLE, BLOQUE_CRUDO, BLOQUE_RLE)
+  ====================================================*/
+
+/*
+  Con datos ya comprimidos (o aleatorios) los codigos de huffman no bajan de
+  8 bits por caracter y la cabecera los hace crecer: armar el codigo y
+  codificar es trabajo perdido. Con un solo caracter el codigo optimo tiene
+  0 bits y no hay nada que decodificar. En esos casos el histograma alcanza
+  para decidir y los datos se guardan tal cual (se copian con memcpy) o como
+  el caracter repetido (se llenan con memset).
+*/
+
+/*
+  Elige como guardar n bytes (n > 0) con esas frecuencias, sin armar el codigo:
+  BLOQUE_RLE si hay un solo caracter, BLOQUE_CRUDO si los codigos no pueden
+  ocupar menos que los datos y BLOQUE_HUFFMAN si vale la pena armarlos.
+  Ningun codigo de prefijo baja de la entropia de las frecuencias y cada
+  caracter usado ocupa al menos 2 bits en la cabecera (en canonico_escribir la
+  distancia y la longitud, en el arbol la hoja y el caracter), asi que si eso
+  ya llega a 8 bits por caracter no se gana nada. Si no, quien llama compara
+  ademas el tamano exacto con las longitudes ya armadas.
+*/
+static int elegir_tipo(const unsigned long long* frecuencias, size_t n) {
+    double bits = 0;
+    int usados = 0;
+    for (int s = 0; s < NUM_CHARS; s++) {
+        if (frecuencias[s] == 0) continue;
+        usados++;
+        bits += (double)frecuencias[s] * log2((double)n / (double)frecuencias[s]);
+    }
+    if (usados == 1) return BLOQUE_RLE;
+    if (bits + 2.0 * usados >= 8.0 * (double)n) return BLOQUE_CRUDO;
+    return BLOQUE_HUFFMAN;
+}
+
+/*
+  Escribe los n bytes de datos en salida sin codigos: el byte de modo y la
+  cantidad como en los otros modos, y despues los datos tal cual (MODO_CRUDO)
+  o el unico caracter (MODO_RLE).
+  retorna el tamano del resultado, -1 si no entra en cap
+*/
+static long long guardar_sin_codigos(int modo, const unsigned char* datos, size_t n, unsigned char* salida, size_t cap) {
+    EST_NUEVA_MARCA(m);
+    struct _BitWriter escritor;
+    InitBitWriterMem(&escritor, salida, cap);
+    PutBits(&escritor, (unsigned long long)(modo | MODO_CON_CUENTA), 8);
+    _escribir_cuenta(&escritor, n);
+    long long tam = FlushBitWriterMem(&escritor);
+    size_t resto = modo == MODO_RLE ? 1 : n;
+    CONFIRM_TRUE(tam >= 0 && cap - (size_t)tam >= resto, -1);
+    memcpy(salida + tam, datos, resto);
+    EST_ETAPA(EST_CODIFICAR, m);
+    EST_CONTAR(simbolos, n);
+    EST_CONTAR(bits_codigos, modo == MODO_RLE ? 0 : 8 * (unsigned long long)n);
+    EST_CONTAR(bits_sin_limite, modo == MODO_RLE ? 0 : 8 * (unsigned long long)n);
+    return tam + (long long)resto;
+}
+
+/*
+  Lee lo que sigue a la cabecera de MODO_CRUDO o MODO_RLE (cuenta caracteres) en salida.
+  retorna el tamano descomprimido, -1 si hubo error o no entra en cap
+*/
+static long long descomprimir_sin_codigos(BitReader in, int modo, long long cuenta, unsigned char* salida, size_t cap) {
+    // estos modos siempre guardan la cantidad
+    CONFIRM_TRUE(cuenta >= 0, -1);
+    if ((unsigned long long)cuenta > cap) {
+        return -1;
+    }
+    EST_NUEVA_MARCA(m);
+    size_t n = (size_t)cuenta;
+    const unsigned char* p = GetBytesMem(in, modo == MODO_RLE ? 1 : n);
+    if (p == NULL) return -1;
+    if (modo == MODO_RLE) memset(salida, p[0], n);
+    else memcpy(salida, p, n);
+    EST_ETAPA(EST_DECODIFICAR, m);
+    EST_CONTAR(simbolos, n);
+    return cuenta;
+}
+
+/*
+  Como descomprimir_sin_codigos pero a un archivo, para la entrada por stdin:
+  copia los datos de a BITIO_BUFFER_SALIDA bytes.
+  retorna 0 si no hay errores
+*/
+static int copiar_sin_codigos(BitReader in, FILE* out, int modo, long long cuenta) {
+    CONFIRM_TRUE(cuenta >= 0, 1);
+    unsigned char* buffer = malloc(BITIO_BUFFER_SALIDA);
+    CONFIRM_NOTNULL(buffer, 1);
+    int error = 0;
+    int lleno = 0;  /* MODO_RLE: el buffer ya tiene el caracter (el primer pedido es el mas grande) */
+    EST_NUEVA_MARCA(m);
+    while (cuenta > 0 && !error) {
+        size_t pedir = (unsigned long long)cuenta < BITIO_BUFFER_SALIDA ? (size_t)cuenta : BITIO_BUFFER_SALIDA;
+        if (modo == MODO_CRUDO) {
+            error = GetBytes(in, buffer, pedir) != pedir;
+        }
+        else if (!lleno) {
+            unsigned char c = 0;
+            error = GetBytes(in, &c, 1) != 1;
+            memset(buffer, c, pedir);
+            lleno = 1;
+        }
+        EST_ETAPA(EST_DECODIFICAR, m);
+        if (error || fwrite(buffer, 1, pedir, out) != pedir) {
+            error = 1;
+            break;
+        }
+        EST_ETAPA(EST_ENTRADA_SALIDA, m);
+        EST_CONTAR(simbolos, pedir);
+        EST_CONTAR(bytes_salida, pedir);
+        cuenta -= (long long)pedir;
+    }
+    free(buffer);
+    return error;
+}
+
+/*====================================================
+     Contextos de orden 1 (MODO_CONTEXTO)
+  ====================================================*/
+
+/*
+  En texto y logs el byte anterior dice mucho del siguiente (despues de 'q'
+  casi siempre viene 'u'). MODO_CONTEXTO elige el codigo de cada byte segun el
+  anterior (el contexto, 0 para el primer byte): hay hasta 256 tablas de
+  longitudes canonicas y un mapa de cada contexto a su tabla. Los contextos que
+  aparecen poco no pagan la cabecera de una tabla propia y comparten una comun
+  (ver agrupar_contextos).
+
+  Formato, despues del byte de modo y la cantidad de caracteres:
+     cantidad de tablas - 1 (8 bits)
+     si hay mas de una: la tabla de cada contexto (256 veces, con los bits justos)
+     las longitudes de cada tabla (canonico_escribir)
+     los codigos
+  Una tabla con un solo simbolo se escribe con longitud 1 pero su codigo no
+  ocupa bits: despues de ese contexto ya se sabe que byte viene.
+
+  retorna el tamano del resultado, -1 si hubo error o no entra en cap
+*/
+static long long comprimir_contexto(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap, const OpcionesHuffman* op, Arena arena) {
+    struct _BitWriter escritor;
+    InitBitWriterMem(&escritor, salida, cap);
+    PutBits(&escritor, (unsigned long long)(MODO_CONTEXTO | MODO_CON_CUENTA), 8);
+    _escribir_cuenta(&escritor, n);
+    if (n == 0) {
+        return FlushBitWriterMem(&escritor); // no hay tablas ni codigos
+    }
+
+    EST_NUEVA_MARCA(m);
+    unsigned long long* frecuencias = arena_pedir(arena, sizeof(unsigned long long) * NUM_CHARS * NUM_CHARS);
+    CONFIRM_NOTNULL(frecuencias, -1);
+    memset(frecuencias, 0, sizeof(unsigned long long) * NUM_CHARS * NUM_CHARS);
+    histograma_contar_contexto(datos, n, frecuencias);
+    EST_ETAPA(EST_HISTOGRAMA, m);
+
+    unsigned char mapa[NUM_CHARS];
+    unsigned char* longitudes = arena_pedir(arena, (size_t)MAX_TABLAS_CONTEXTO * NUM_CHARS);
+    CONFIRM_NOTNULL(longitudes, -1);
+    int limite = op->max_longitud > 0 ? op->max_longitud : CANONICO_MAX_LONGITUD;
+    int tablas = agrupar_contextos(frecuencias, limite, mapa, longitudes, arena);
+    CONFIRM_TRUE(tablas > 0, -1);
+    EST_ETAPA(EST_ARBOL, m);
+
+    // codigo y largo de cada (tabla, byte) en un solo arreglo, el indice es tabla * 256 + byte
+    unsigned int* codigos = arena_pedir(arena, sizeof(unsigned int) * (size_t)tablas * NUM_CHARS);
+    unsigned char* largos = arena_pedir(arena, (size_t)tablas * NUM_CHARS);
+    CONFIRM_TRUE(codigos != NULL && largos != NULL, -1);
+    int maxima = 0;
+    for (int t = 0; t < tablas; t++) {
+        const unsigned char* l = longitudes + (size_t)t * NUM_CHARS;
+        CONFIRM_TRUE(0 == canonico_codigos(l, NUM_CHARS, codigos + (size_t)t * NUM_CHARS), -1);
+        int unico = _simbolos_usados(l) == 1;
+        for (int s = 0; s < NUM_CHARS; s++) {
+            largos[(size_t)t * NUM_CHARS + s] = unico ? 0 : l[s];
+            if (!unico && l[s] > maxima) maxima = l[s];
+        }
+    }
+    EST_ETAPA(EST_TABLA, m);
+
+    PutBits(&escritor, (unsigned long long)(tablas - 1), 8);
+    if (tablas > 1) {
+        int ancho = _ancho_bits((unsigned int)tablas - 1);
+        for (int c = 0; c < NUM_CHARS; c++) {
+            PutBits(&escritor, mapa[c], ancho);
+        }
+    }
+    for (int t = 0; t < tablas; t++) {
+        canonico_escribir(&escritor, longitudes + (size_t)t * NUM_CHARS, NUM_CHARS);
+    }
+
+    // la tabla de cada byte la elige el anterior
+    unsigned long long inicio = (unsigned long long)escritor.pos * 8 + (unsigned long long)escritor.n;
+    unsigned char anterior = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t k = ((size_t)mapa[anterior] << 8) | datos[i];
+        PutBits(&escritor, codigos[k], largos[k]);
+        anterior = datos[i];
+    }
+    EST_CONTAR(bits_codigos, (unsigned long long)escritor.pos * 8 + (unsigned long long)escritor.n - inicio);
+    EST_CONTAR(bits_sin_limite, (unsigned long long)escritor.pos * 8 + (unsigned long long)escritor.n - inicio);
+    EST_ETAPA(EST_CODIFICAR, m);
+    EST_CONTAR(simbolos, n);
+    EST_MAXIMO(profundidad, maxima);
+    return FlushBitWriterMem(&escritor);
+}
+
+/*
+  Reparte los contextos en tablas. Empieza con todos en una tabla comun y en
+  cada ronda un contexto pasa a tener su propia tabla si sus codigos mas la
+  cabecera de la tabla ocupan menos bits que con la comun (y vuelve si no),
+  despues la comun se recalcula con los que quedan. Al final, si las tablas
+  propias no pagan el mapa, queda una sola tabla con todo.
+  mapa[c] queda con la tabla del contexto c y longitudes con las de cada
+  tabla (256 por tabla, la comun primero)
+
+  retorna la cantidad de tablas, -1 si hubo error
+*/
+static int agrupar_contextos(const unsigned long long* frecuencias, int limite, unsigned char* mapa, unsigned char* longitudes, Arena arena) {
+    // los constructores piden memoria en cada llamada: sale de una arena chica que se vacia cada vez
+    void* mem = arena_pedir(arena, TRABAJO_CONTEXTO);
+    unsigned char* propias = arena_pedir(arena, (size_t)NUM_CHARS * NUM_CHARS);
+    Arena trabajo = mem != NULL ? arena_crear_en(mem, TRABAJO_CONTEXTO) : NULL;
+    CONFIRM_TRUE(propias != NULL && trabajo != NULL, -1);
+
+    unsigned long long costo_propio[NUM_CHARS];
+    unsigned long long suma[NUM_CHARS];
+    unsigned char comun[NUM_CHARS];
+    unsigned char usado[NUM_CHARS];
+    int error = 0;
+    for (int c = 0; c < NUM_CHARS && !error; c++) {
+        const unsigned long long* f = frecuencias + (size_t)c * NUM_CHARS;
+        usado[c] = 0;
+        for (int s = 0; s < NUM_CHARS; s++) {
+            if (f[s] > 0) usado[c] = 1;
+        }
+        comun[c] = usado[c];
+        if (usado[c]) {
+            unsigned char* l = propias + (size_t)c * NUM_CHARS;
+            arena_vaciar(trabajo);
+            error = _longitudes_tabla(f, NUM_CHARS, limite, l, trabajo);
+            costo_propio[c] = _costo_tabla(f, l) + _bits_cabecera(l);
+        }
+    }
+
+    unsigned char* l_comun = longitudes;
+    for (int ronda = 0; ronda < RONDAS_CONTEXTO && !error; ronda++) {
+        _sumar_contextos(frecuencias, comun, suma);
+        arena_vaciar(trabajo);
+        error = _longitudes_tabla(suma, NUM_CHARS, limite, l_comun, trabajo);
+        int cambios = 0;
+        for (int c = 0; c < NUM_CHARS && !error; c++) {
+            if (!usado[c]) continue;
+            unsigned char nuevo = _costo_tabla(frecuencias + (size_t)c * NUM_CHARS, l_comun) <= costo_propio[c];
+            if (nuevo != comun[c]) {
+                comun[c] = nuevo;
+                cambios++;
+            }
+        }
+        if (cambios == 0) break;
+    }
+
+    // bits de lo elegido contra los de una sola tabla
+    int hay_comun = 0;
+    int tablas = 0;
+    unsigned long long costo = 0;
+    if (!error && _sumar_contextos(frecuencias, comun, suma) > 0) {
+        arena_vaciar(trabajo);
+        error = _longitudes_tabla(suma, NUM_CHARS, limite, l_comun, trabajo);
+        hay_comun = 1;
+        tablas = 1;
+        costo = _bits_cabecera(l_comun);
+    }
+    for (int c = 0; c < NUM_CHARS && !error; c++) {
+        if (!usado[c]) continue;
+        if (comun[c]) costo += _costo_tabla(frecuencias + (size_t)c * NUM_CHARS, l_comun);
+        else {
+            costo += costo_propio[c];
+            tablas++;
+        }
+    }
+    if (tablas > 1) costo += (unsigned long long)NUM_CHARS * _ancho_bits((unsigned int)tablas - 1);
+
+    unsigned char unica[NUM_CHARS];
+    unsigned char todos[NUM_CHARS];
+    memset(todos, 1, sizeof(todos));
+    _sumar_contextos(frecuencias, todos, suma);
+    arena_vaciar(trabajo);
+    if (!error) error = _longitudes_tabla(suma, NUM_CHARS, limite, unica, trabajo);
+    arena_destruir(trabajo);
+    CONFIRM_TRUE(!error, -1);
+    if (tablas <= 1 || _costo_tabla(suma, unica) + _bits_cabecera(unica) <= costo) {
+        memcpy(longitudes, unica, NUM_CHARS);
+        memset(mapa, 0, NUM_CHARS);
+        return 1;
+    }
+
+    // la comun (si hay) es la 0, despues las propias en orden de contexto
+    int t = hay_comun;
+    for (int c = 0; c < NUM_CHARS; c++) {
+        mapa[c] = 0;
+        if (!usado[c] || comun[c]) continue;
+        mapa[c] = (unsigned char)t;
+        memcpy(longitudes + (size_t)t * NUM_CHARS, propias + (size_t)c * NUM_CHARS, NUM_CHARS);
+        t++;
+    }
+    return tablas;
+}
+
+/*
+  Lee el mapa y las tablas de MODO_CONTEXTO y arma la tabla de decodificacion
+  de cada una. La tabla primaria de cada una tiene los bits de su codigo mas
+  largo (hasta BITS_CONTEXTO): con muchas tablas chicas entran todas en cache.
+  Una sola tabla se arma con TABLADEC_BITS, como en MODO_CANONICO.
+  Todo sale de la arena.
+  retorna NULL si la cabecera no es valida
+*/
+static TablasContexto* leer_contextos(BitReader in, Arena arena) {
+    TablasContexto* tc = arena_pedir(arena, sizeof(TablasContexto));
+    CONFIRM_NOTNULL(tc, NULL);
+    if (FillBits(in) < 8) return NULL;
+    int tablas = (int)GetBits(in, 8) + 1;
+    unsigned char mapa[NUM_CHARS] = { 0 };
+    if (tablas > 1) {
+        int ancho = _ancho_bits((unsigned int)tablas - 1);
+        for (int c = 0; c < NUM_CHARS; c++) {
+            unsigned int t = (unsigned int)GetBits(in, ancho);
+            if (t >= (unsigned int)tablas) return NULL;
+            mapa[c] = (unsigned char)t;
+        }
+    }
+
+    ContextoDec* de_tabla = arena_pedir(arena, sizeof(ContextoDec) * tablas);
+    CONFIRM_NOTNULL(de_tabla, NULL);
+    tc->bmax = 1;
+    tc->unica = NULL;
+    for (int t = 0; t < tablas; t++) {
+        unsigned char l[NUM_CHARS];
+        unsigned int codigos[NUM_CHARS];
+        if (canonico_leer(in, l, NUM_CHARS) != 0) return NULL;
+        int usados = _simbolos_usados(l);
+        if (usados == 0) return NULL;
+        if (usados == 1) {
+            // el unico simbolo sale sin consumir bits
+            EntradaDec* e = arena_pedir(arena, sizeof(EntradaDec));
+            CONFIRM_NOTNULL(e, NULL);
+            memset(e, 0, sizeof(EntradaDec));
+            for (int s = 0; s < NUM_CHARS; s++) {
+                if (l[s] > 0) e->valor = (unsigned int)s;
+            }
+            e->nsim = 1;
+            de_tabla[t].entradas = e;
+            de_tabla[t].mascara = 0;
+            de_tabla[t].tabla = NULL;
+            continue;
+        }
+        int maxima = 0;
+        for (int s = 0; s < NUM_CHARS; s++) {
+            if (l[s] > maxima) maxima = l[s];
+        }
+        int bits = tablas == 1 ? TABLADEC_BITS : maxima < BITS_CONTEXTO ? maxima : BITS_CONTEXTO;
+        if (canonico_codigos(l, NUM_CHARS, codigos) != 0) return NULL;
+        TablaDec td = tabladec_crear_arena(codigos, l, NUM_CHARS, bits, arena);
+        if (td == NULL) return NULL;
+        de_tabla[t].entradas = td->entradas;
+        de_tabla[t].mascara = (1u << bits) - 1;
+        de_tabla[t].tabla = td;
+        if (maxima > tc->bmax) tc->bmax = maxima;
+        if (tablas == 1) tc->unica = td;
+    }
+    for (int c = 0; c < NUM_CHARS; c++) {
+        tc->ctx[c] = de_tabla[mapa[c]];
+    }
+    return tc;
+}
+
+/*
+  Decodifica hasta max caracteres de in a destino con las tablas de cada
+  contexto. anterior es el ultimo byte decodificado (0 al principio) y queda
+  con el nuevo, asi se puede seguir en otra llamada. Cada byte depende del
+  anterior, asi que no se usan las entradas de a dos simbolos de la tabla
+  (bits1 y los 16 bits bajos de valor son los del primero).
+  retorna la cantidad de caracteres decodificados
+*/
+static size_t decodificar_contexto(BitReader in, const TablasContexto* tc, unsigned char* destino, size_t max, unsigned char* anterior) {
+    if (tc->unica != NULL) {
+        // el contexto no cambia la tabla: se pueden sacar dos simbolos por entrada
+        size_t n = decodificar_memoria(in, tc->unica, destino, max);
+        if (n > 0) *anterior = destino[n - 1];
+        return n;
+    }
+    const ContextoDec* ctx = tc->ctx;
+    unsigned char a = *anterior;
+    size_t pos = 0;
+
+    while (pos < max) {
+        size_t vueltas = _vueltas_seguras(in->buf + in->pos, in->buf + in->tam, destino + pos, destino + max, tc->bmax);
+        if (vueltas > 0) {
+            unsigned long long acc = in->acc;
+            int n = in->n;
+            const unsigned char* p = in->buf + in->pos;
+            unsigned char* d = destino + pos;
+            int error = 0;
+            for (; vueltas > 0; vueltas--) {
+                if (n <= 56) {
+                    acc |= BITIO_LEER64(p) << n;
+                    p += (63 - n) >> 3;
+                    n |= 56;
+                }
+                const ContextoDec* c = &ctx[a];
+                EntradaDec e = c->entradas[acc & c->mascara];
+                int usados = 0;
+                if (e.nsim == 0) {
+                    int u = 0;
+                    e = tabladec_subtabla(c->tabla, e, acc, &u);
+                    usados = u;
+                    if (e.nsim == 0) {
+                        error = 1;
+                        break;
+                    }
+                }
+                a = (unsigned char)e.valor;
+                *d++ = a;
+                acc >>= usados + e.bits1;
+                n -= usados + e.bits1;
+            }
+            in->acc = acc;
+            in->n = n;
+            in->pos = (size_t)(p - in->buf);
+            pos = (size_t)(d - destino);
+            if (error) {
+                break;
+            }
+            continue;
+        }
+
+        // al final del flujo: con pocos bits (o ninguno, si el codigo no ocupa bits)
+        int n = FillBits(in);
+        unsigned long long acc = in->acc;
+        const ContextoDec* c = &ctx[a];
+        EntradaDec e = c->entradas[acc & c->mascara];
+        int usados = 0;
+        if (e.nsim == 0) {
+            e = tabladec_subtabla(c->tabla, e, acc, &usados);
+            if (e.nsim == 0) {
+                break;
+            }
+        }
+        int bits = usados + e.bits1;
+        if (bits > n) {
+            break; // lo que queda es relleno
+        }
+        a = (unsigned char)e.valor;
+        destino[pos++] = a;
+        in->acc >>= bits;
+        in->n -= bits;
+    }
+    *anterior = a;
+    return pos;
+}
+
+/*
+  Lee las tablas y decodifica exactamente cuenta caracteres en salida.
+  Las tablas salen de la arena, asi que la tabla en cache se pierde.
+  retorna el tamano descomprimido, -1 si hubo error o no entra en cap
+*/
+static long long descomprimir_contexto(BitReader in, long long cuenta, unsigned char* salida, size_t cap, CacheTabla* cache, Arena arena) {
+    if (cuenta == 0) {
+        return 0; // no hay tablas ni codigos
+    }
+    if (cuenta < 0 || (unsigned long long)cuenta > cap) {
+        return -1;
+    }
+    EST_NUEVA_MARCA(m);
+    cache->tabla = NULL;
+    arena_vaciar(arena);
+    TablasContexto* tc = leer_contextos(in, arena);
+    if (tc == NULL) return -1;
+    EST_ETAPA(EST_TABLA, m);
+
+    unsigned char anterior = 0;
+    size_t n = decodificar_contexto(in, tc, salida, (size_t)cuenta, &anterior);
+    EST_ETAPA(EST_DECODIFICAR, m);
+    EST_CONTAR(simbolos, n);
+    return n == (size_t)cuenta ? cuenta : -1;
+}
+
+/*====================================================
+     Alfabetos de 16 bits (MODO_SIMBOLOS16, ver huffman_simbolos.h)
+  ====================================================*/
+
+/*
+  Cada muestra de 2 bytes (little endian) es un simbolo de un alfabeto de hasta
+  SIMBOLOS_MAX. Formato, despues del byte de modo y la cantidad de bytes originales:
+     cantidad de simbolos del alfabeto - 1 (16 bits)
+     las longitudes canonicas (canonico_escribir: solo van los simbolos usados)
+     si la cantidad de bytes es impar, el ultimo byte (8 bits)
+     el codigo de cada muestra
+  comprimir_simbolos escribe 2 bytes por simbolo, asi los dos caminos leen lo mismo.
+*/
+
+/* retorna el tamano maximo del resultado de comprimir n simbolos de un alfabeto de num_simbolos */
+size_t simbolos_cota(size_t n, int num_simbolos) {
+    if (num_simbolos <= 0 || num_simbolos > SIMBOLOS_MAX) {
+        num_simbolos = SIMBOLOS_MAX;
+    }
+    // los codigos nunca ocupan mas que el codigo fijo de 16 bits
+    return 1 + MAX_TAM_VARIABLE + 2 + CABECERA_SIMBOLOS(num_simbolos) + 1 + 2 * n + 8;
+}
+
+/* Comprime los n simbolos (menores que num_simbolos) en salida
+retorna el tamano del resultado, -1 si hubo error o no entra en cap */
+long long comprimir_simbolos(const unsigned short* simbolos, size_t n, int num_simbolos, int max_longitud, unsigned char* salida, size_t cap) {
+    CONFIRM_TRUE(simbolos != NULL || n == 0, -1);
+    CONFIRM_NOTNULL(salida, -1);
+    CONFIRM_TRUE(num_simbolos > 0 && num_simbolos <= SIMBOLOS_MAX, -1);
+    CONFIRM_TRUE(max_longitud >= 0 && max_longitud <= CANONICO_MAX_LONGITUD, -1);
+
+    EST_EMPEZAR(est);
+    Arena arena = arena_crear(0);
+    long long tam = -1;
+    if (arena != NULL) {
+        tam = comprimir_simbolos16(NULL, simbolos, 2 * n, num_simbolos, max_longitud, salida, cap, arena);
+    }
+    arena_destruir(arena);
+    EST_CONTAR(bytes_entrada, 2 * n);
+    EST_CONTAR(bytes_salida, tam < 0 ? 0 : (unsigned long long)tam);
+    EST_TERMINAR(est);
+    return tam;
+}
+
+/* Descomprime los tam bytes de datos en salida (de cap simbolos)
+retorna la cantidad de simbolos, -1 si hubo error o no entran en cap */
+long long descomprimir_simbolos(const unsigned char* datos, size_t tam, unsigned short* salida, size_t cap) {
+    CONFIRM_TRUE(datos != NULL && tam > 0, -1);
+    CONFIRM_TRUE(salida != NULL || cap == 0, -1);
+
+    EST_EMPEZAR(est);
+    struct _BitReader lector;
+    InitBitReaderMem(&lector, datos, tam);
+    int modo = -1;
+    long long cuenta = -1;
+    long long resultado = -1;
+    Arena arena = arena_crear(0);
+    if (arena != NULL && _leer_modo(&lector, &modo, &cuenta) == 0 && modo == MODO_SIMBOLOS16 && cuenta >= 0 && cuenta % 2 == 0) {
+        resultado = descomprimir_simbolos16(&lector, cuenta, NULL, salida, 2 * cap, NULL, arena);
+    }
+    arena_destruir(arena);
+    EST_CONTAR(bytes_entrada, tam);
+    EST_CONTAR(bytes_salida, resultado < 0 ? 0 : (unsigned long long)resultado);
+    EST_TERMINAR(est);
+    return resultado < 0 ? -1 : resultado / 2;
+}
+
+/*
+  Comprime n bytes en MODO_SIMBOLOS16: los de datos, o si datos es NULL los
+  n / 2 simbolos de simbolos. Todo el alfabeto tiene frecuencias de 64 bits
+  (512 KiB de la arena), pero las longitudes, los codigos y la cabecera son
+  solo de los num_simbolos primeros.
+
+  retorna el tamano del resultado, -1 si hubo error o no entra en cap
+*/
+static long long comprimir_simbolos16(const unsigned char* datos, const unsigned short* simbolos, size_t n, int num_simbolos, int max_longitud, unsigned char* salida, size_t cap, Arena arena) {
+    struct _BitWriter escritor;
+    InitBitWriterMem(&escritor, salida, cap);
+    PutBits(&escritor, (unsigned long long)(MODO_SIMBOLOS16 | MODO_CON_CUENTA), 8);
+    _escribir_cuenta(&escritor, n);
+    if (n == 0) {
+        return FlushBitWriterMem(&escritor); // no hay longitudes ni codigos
+    }
+    size_t muestras = n / 2;
+
+    // las muestras de datos se arman de a tramos, los simbolos se usan directo
+    EST_NUEVA_MARCA(m);
+    unsigned long long* frecuencias = arena_pedir(arena, sizeof(unsigned long long) * SIMBOLOS_MAX);
+    unsigned short* tramo = datos != NULL ? arena_pedir(arena, sizeof(unsigned short) * TRAMO_MUESTRAS) : NULL;
+    CONFIRM_TRUE(frecuencias != NULL && (datos == NULL || tramo != NULL), -1);
+    memset(frecuencias, 0, sizeof(unsigned long long) * SIMBOLOS_MAX);
+    for (size_t i = 0; i < muestras; i += TRAMO_MUESTRAS) {
+        size_t k = muestras - i < TRAMO_MUESTRAS ? muestras - i : TRAMO_MUESTRAS;
+        histograma_contar16(_muestras(datos, simbolos, i, k, tramo), k, frecuencias);
+    }
+    for (int s = num_simbolos; s < SIMBOLOS_MAX; s++) {
+        CONFIRM_TRUE(frecuencias[s] == 0, -1); // simbolo fuera del alfabeto
+    }
+    EST_ETAPA(EST_HISTOGRAMA, m);
+
+    unsigned char* longitudes = arena_pedir(arena, (size_t)num_simbolos);
+    unsigned int* codigos = arena_pedir(arena, sizeof(unsigned int) * num_simbolos);
+    CONFIRM_TRUE(longitudes != NULL && codigos != NULL, -1);
+    int limite = max_longitud > 0 ? max_longitud : CANONICO_MAX_LONGITUD;
+    CONFIRM_TRUE(0 == _longitudes_tabla(frecuencias, num_simbolos, limite, longitudes, arena), -1);
+    EST_ETAPA(EST_ARBOL, m);
+    CONFIRM_TRUE(0 == canonico_codigos(longitudes, num_simbolos, codigos), -1);
+    EST_ETAPA(EST_TABLA, m);
+
+    PutBits(&escritor, (unsigned long long)(num_simbolos - 1), 16);
+    canonico_escribir(&escritor, longitudes, num_simbolos);
+    if (n % 2 != 0) {
+        PutBits(&escritor, datos[n - 1], 8);
+    }
+    unsigned long long inicio = (unsigned long long)escritor.pos * 8 + (unsigned long long)escritor.n;
+    for (size_t i = 0; i < muestras; i += TRAMO_MUESTRAS) {
+        size_t k = muestras - i < TRAMO_MUESTRAS ? muestras - i : TRAMO_MUESTRAS;
+        const unsigned short* s = _muestras(datos, simbolos, i, k, tramo);
+        for (size_t j = 0; j < k; j++) {
+            PutBits(&escritor, codigos[s[j]], longitudes[s[j]]);
+        }
+    }
+    int maxima = 0;
+    for (int s = 0; s < num_simbolos; s++) {
+        if (longitudes[s] > maxima) maxima = longitudes[s];
+    }
+    EST_CONTAR(bits_codigos, (unsigned long long)escritor.pos * 8 + (unsigned long long)escritor.n - inicio);
+    EST_CONTAR(bits_sin_limite, (unsigned long long)escritor.pos * 8 + (unsigned long long)escritor.n - inicio);
+    EST_ETAPA(EST_CODIFICAR, m);
+    EST_CONTAR(simbolos, muestras);
+    EST_MAXIMO(profundidad, maxima);
+    return FlushBitWriterMem(&escritor);
+}
+
+/*
+  Lee la cabecera de MODO_SIMBOLOS16 que sigue a la cantidad de bytes (cuenta)
+  y arma la tabla de decodificacion en la arena. La primaria tiene los bits
+  justos para los simbolos usados (ver BITS_SIMBOLOS) y las subtablas solo
+  existen para los codigos usados, asi la tabla crece con los simbolos que
+  aparecen y no con el alfabeto.
+  *tabla queda en NULL si no hay muestras y *ultimo con el byte suelto del final (-1 si no hay)
+  retorna 0 si no hay errores
+*/
+static int leer_simbolos16(BitReader in, long long cuenta, TablaDec* tabla, int* ultimo, Arena arena) {
+    *tabla = NULL;
+    *ultimo = -1;
+    if (FillBits(in) < 16) return 1;
+    int num_simbolos = (int)GetBits(in, 16) + 1;
+    unsigned char* longitudes = arena_pedir(arena, (size_t)num_simbolos);
+    unsigned int* codigos = arena_pedir(arena, sizeof(unsigned int) * num_simbolos);
+    CONFIRM_TRUE(longitudes != NULL && codigos != NULL, 1);
+    if (canonico_leer(in, longitudes, num_simbolos) != 0) return 1;
+    if (cuenta % 2 != 0) {
+        if (FillBits(in) < 8) return 1;
+        *ultimo = (int)GetBits(in, 8);
+    }
+    if (cuenta < 2) return 0;
+
+    int maxima = 0;
+    int usados = 0;
+    for (int s = 0; s < num_simbolos; s++) {
+        if (longitudes[s] > maxima) maxima = longitudes[s];
+        if (longitudes[s] > 0) usados++;
+    }
+    if (maxima == 0 || canonico_codigos(longitudes, num_simbolos, codigos) != 0) return 1;
+    int bits = TABLADEC_BITS;
+    while (bits < BITS_SIMBOLOS && (1 << bits) < usados) bits++;
+    *tabla = tabladec_crear_arena(codigos, longitudes, num_simbolos, bits < maxima ? bits : maxima, arena);
+    return *tabla == NULL;
+}
+
+/*
+  Lee la cabecera y decodifica exactamente cuenta bytes: en datos, o si datos
+  es NULL en simbolos (cuenta / 2). cap es el lugar en bytes.
+  La tabla sale de la arena, asi que la tabla en cache (si hay) se pierde.
+  retorna cuenta, -1 si hubo error o no entra en cap
+*/
+static long long descomprimir_simbolos16(BitReader in, long long cuenta, unsigned char* datos, unsigned short* simbolos, size_t cap, CacheTabla* cache, Arena arena) {
+    if (cuenta == 0) {
+        return 0; // no hay longitudes ni codigos
+    }
+    if (cuenta < 0 || (unsigned long long)cuenta > cap) {
+        return -1;
+    }
+    EST_NUEVA_MARCA(m);
+    if (cache != NULL) cache->tabla = NULL;
+    arena_vaciar(arena);
+    TablaDec t = NULL;
+    int ultimo = -1;
+    if (leer_simbolos16(in, cuenta, &t, &ultimo, arena) != 0) return -1;
+    EST_ETAPA(EST_TABLA, m);
+
+    size_t muestras = (size_t)cuenta / 2;
+    size_t hechas = 0;
+    if (datos == NULL) {
+        hechas = muestras > 0 ? decodificar_simbolos(in, t, simbolos, muestras) : 0;
+    }
+    else {
+        // de a tramos y despues a bytes
+        unsigned short* tramo = arena_pedir(arena, sizeof(unsigned short) * TRAMO_MUESTRAS);
+        CONFIRM_NOTNULL(tramo, -1);
+        while (hechas < muestras) {
+            size_t k = muestras - hechas < TRAMO_MUESTRAS ? muestras - hechas : TRAMO_MUESTRAS;
+            size_t r = decodificar_simbolos(in, t, tramo, k);
+            _bytes_muestras(tramo, r, datos + 2 * hechas);
+            hechas += r;
+            if (r < k) break;
+        }
+        if (ultimo >= 0) {
+            datos[cuenta - 1] = (unsigned char)ultimo;
+        }
+    }
+    EST_ETAPA(EST_DECODIFICAR, m);
+    EST_CONTAR(simbolos, hechas);
+    return hechas == muestras ? cuenta : -1;
+}
+
+/*
+  Como decodificar pero para MODO_SIMBOLOS16: lee la cabecera y escribe los
+  cuenta bytes en out de a tramos.
+  retorna 0 si no hay errores
+*/
+static int decodificar_simbolos16(BitReader in, FILE* out, long long cuenta) {
+    CONFIRM_TRUE(cuenta >= 0, 1);
+    if (cuenta == 0) {
+        return 0;
+    }
+    EST_NUEVA_MARCA(m);
+    Arena arena = arena_crear(0);
+    TablaDec t = NULL;
+    int ultimo = -1;
+    if (arena == NULL || leer_simbolos16(in, cuenta, &t, &ultimo, arena) != 0) {
+        arena_destruir(arena);
+        return 1;
+    }
+    EST_ETAPA(EST_TABLA, m);
+    unsigned short* tramo = arena_pedir(arena, sizeof(unsigned short) * TRAMO_MUESTRAS);
+    unsigned char* buffer = arena_pedir(arena, 2 * TRAMO_MUESTRAS);
+    int error = tramo == NULL || buffer == NULL;
+
+    size_t muestras = (size_t)cuenta / 2;
+    size_t hechas = 0;
+    while (!error && hechas < muestras) {
+        size_t k = muestras - hechas < TRAMO_MUESTRAS ? muestras - hechas : TRAMO_MUESTRAS;
+        size_t r = decodificar_simbolos(in, t, tramo, k);
+        _bytes_muestras(tramo, r, buffer);
+        EST_ETAPA(EST_DECODIFICAR, m);
+        EST_CONTAR(simbolos, r);
+        if (fwrite(buffer, 1, 2 * r, out) != 2 * r || r < k) {
+            error = 1;
+        }
+        EST_ETAPA(EST_ENTRADA_SALIDA, m);
+        hechas += r;
+    }
+    if (!error && ultimo >= 0) {
+        unsigned char b = (unsigned char)ultimo;
+        error = fwrite(&b, 1, 1, out) != 1;
+    }
+    EST_CONTAR(bytes_salida, error ? 0 : (unsigned long long)cuenta);
+    arena_destruir(arena);
+    return error;
+}
+
+/*
+  Decodifica hasta max simbolos de 16 bits de in a destino, como
+  decodificar_memoria: el ciclo rapido mientras alcanzan los bytes de in y el
+  lugar de destino, y el final de a un codigo.
+  retorna la cantidad de simbolos decodificados
+*/
+static size_t decodificar_simbolos(BitReader in, TablaDec t, unsigned short* destino, size_t max) {
+    unsigned long long mascara = (1u << t->bits_primaria) - 1;
+    const EntradaDec* entradas = t->entradas;
+    int bmax = t->max_longitud > t->bits_primaria ? t->max_longitud : t->bits_primaria;
+    size_t pos = 0;
+
+    while (pos < max) {
+        // _vueltas_seguras cuenta lugares: se le pasa el lugar que queda en simbolos
+        const unsigned char* lugar = (const unsigned char*)destino;
+        size_t vueltas = _vueltas_seguras(in->buf + in->pos, in->buf + in->tam, lugar + pos, lugar + max, bmax);
+        if (vueltas > 0) {
+            unsigned long long acc = in->acc;
+            int n = in->n;
+            const unsigned char* p = in->buf + in->pos;
+            unsigned short* d = destino + pos;
+            int error = 0;
+            for (; vueltas > 0; vueltas--) {
+                if (n <= 56) {
+                    acc |= BITIO_LEER64(p) << n;
+                    p += (63 - n) >> 3;
+                    n |= 56;
+                }
+                EntradaDec e = entradas[acc & mascara];
+                int usados = 0;
+                if (e.nsim == 0) {
+                    int u = 0;
+                    e = tabladec_subtabla(t, e, acc, &u);
+                    usados = u;
+                    if (e.nsim == 0) {
+                        error = 1;
+                        break;
+                    }
+                }
+                d[0] = (unsigned short)e.valor;
+                d[1] = (unsigned short)(e.valor >> 16);
+                d += e.nsim;
+                acc >>= usados + e.bits;
+                n -= usados + e.bits;
+            }
+            in->acc = acc;
+            in->n = n;
+            in->pos = (size_t)(p - in->buf);
+            pos = (size_t)(d - destino);
+            if (error) {
+                break;
+            }
+            continue;
+        }
+
+        int n = FillBits(in);
+        unsigned long long acc = in->acc;
+        if (n == 0) {
+            break;
+        }
+        EntradaDec e = entradas[acc & mascara];
+        int usados = 0;
+        if (e.nsim == 0) {
+            e = tabladec_subtabla(t, e, acc, &usados);
+            if (e.nsim == 0) {
+                break;
+            }
+        }
+        int bits = usados + e.bits;
+        if (e.nsim == 2 && (bits > n || pos + 2 > max)) {
+            e.nsim = 1;
+            bits = e.bits1;
+        }
+        if (bits > n) {
+            break; // lo que queda es relleno
+        }
+        destino[pos++] = (unsigned short)e.valor;
+        if (e.nsim == 2) {
+            destino[pos++] = (unsigned short)(e.valor >> 16);
+        }
+        in->acc >>= bits;
+        in->n -= bits;
+    }
+    return pos;
+}
+
+/*====================================================
+     Modelo compartido (ver huffman_modelo.h)
+  ====================================================*/
+
+/* El modelo: longitudes canonicas, codigos y tabla de decodificacion, armados una sola vez */
+struct _ModeloHuffman {
+    unsigned char longitudes[NUM_CHARS];
+    unsigned int codigos[NUM_CHARS];
+    int max_longitud;
+    TablaDec tabla;
+};
+
+/*
+  Entrena un modelo con las frecuencias de los num archivos de ejemplo.
+  retorna NULL si hubo error
+*/
+ModeloHuffman modelo_entrenar(char** archivos, int num, int max_longitud) {
+    CONFIRM_NOTNULL(archivos, NULL);
+    CONFIRM_TRUE(num > 0, NULL);
+    CONFIRM_TRUE(max_longitud == 0 || (max_longitud >= 8 && max_longitud <= CANONICO_MAX_LONGITUD), NULL);
+    unsigned long long frecuencias[NUM_CHARS] = { 0 };
+
+    // las frecuencias de todos los ejemplos se suman
+    for (int i = 0; i < num; i++) {
+        Mapeo mapa = mapeo_abrir(archivos[i]);
+        if (mapa != NULL) {
+            histograma_contar(mapa->datos, mapa->tam, frecuencias);
+            mapeo_cerrar(mapa);
+        }
+        else if (calcular_frecuencias(frecuencias, archivos[i]) != 0) {
+            return NULL;
+        }
+    }
+    // cada byte cuenta al menos una vez, asi los que no estan en los ejemplos tambien tienen codigo
+    for (int s = 0; s < NUM_CHARS; s++) {
+        frecuencias[s]++;
+    }
+    return modelo_desde_frecuencias(frecuencias, max_longitud);
+}
+
+/*
+  Guarda el modelo: MODELO_MAGIA (4 bytes) y las longitudes (canonico_escribir)
+  retorna 0 si no hay errores
+*/
+int modelo_guardar(ModeloHuffman m, char* nombre) {
+    CONFIRM_NOTNULL(m, 1);
+    BitWriter out = OpenBitWriter(nombre);
+    CONFIRM_NOTNULL(out, 1);
+    PutBits(out, MODELO_MAGIA, 32);
+    canonico_escribir(out, m->longitudes, NUM_CHARS);
+    return CloseBitWriter(out) != 0;
+}
+
+/* Carga un modelo guardado con modelo_guardar
+retorna NULL si hubo error */
+ModeloHuffman modelo_cargar(char* nombre) {
+    unsigned char longitudes[NUM_CHARS];
+    BitReader in = OpenBitReader(nombre);
+    CONFIRM_NOTNULL(in, NULL);
+    int error = GetBits(in, 32) != MODELO_MAGIA || canonico_leer(in, longitudes, NUM_CHARS) != 0;
+    CloseBitReader(in);
+    if (error) {
+        fprintf(stderr, "Modelo invalido en %s\n", nombre);
+        return NULL;
+    }
+    return modelo_desde_longitudes(longitudes);
+}
+
+/* Libera el modelo */
+void modelo_destruir(ModeloHuffman m) {
+    if (m == NULL) return;
+    tabladec_destruir(m->tabla);
+    free(m);
+}
+
+/* retorna el tamano maximo que puede ocupar un mensaje de n bytes codificado con el modelo */
+size_t modelo_cota(ModeloHuffman m, size_t n) {
+    CONFIRM_NOTNULL(m, 0);
+    return MAX_TAM_VARIABLE + (n * (size_t)m->max_longitud + 7) / 8;
+}
+
+/*
+  Codifica los n bytes de datos en salida (de cap bytes):
+  el tamano original de a 7 bits por byte (el bit alto indica que sigue otro)
+  y los codigos del modelo completados hasta el byte.
+  retorna el tamano del mensaje codificado, -1 si hubo error o no entra en cap
+*/
+long long modelo_comprimir(ModeloHuffman m, const unsigned char* datos, size_t n, unsigned char* salida, size_t cap) {
+    CONFIRM_NOTNULL(m, -1);
+    CONFIRM_TRUE(datos != NULL || n == 0, -1);
+    CONFIRM_NOTNULL(salida, -1);
+
+    struct _BitWriter escritor;
+    InitBitWriterMem(&escritor, salida, cap);
+    _escribir_cuenta(&escritor, n);
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = datos[i];
+        PutBits(&escritor, m->codigos[c], m->longitudes[c]);
+    }
+    return FlushBitWriterMem(&escritor);
+}
+
+/* Decodifica un mensaje de tam bytes en salida (de cap bytes)
+retorna la cantidad de bytes decodificados, -1 si hubo error o no entran en cap */
+long long modelo_descomprimir(ModeloHuffman m, const unsigned char* datos, size_t tam, unsigned char* salida, size_t cap) {
+    CONFIRM_NOTNULL(m, -1);
+    CONFIRM_NOTNULL(datos, -1);
+
+    // tamano original
+    struct _BitReader lector;
+    InitBitReaderMem(&lector, datos, tam);
+    unsigned long long n = 0;
+    if (_leer_cuenta(&lector, &n) != 0 || n > cap) return -1;
+    CONFIRM_TRUE(salida != NULL || n == 0, -1);
+
+    size_t decodificados = decodificar_memoria(&lector, m->tabla, salida, (size_t)n);
+    return decodificados == n ? (long long)n : -1;
+}
+
+/* Arma un modelo con las longitudes de codigo optimas para las frecuencias
+(limitadas a max_longitud, 0 = CANONICO_MAX_LONGITUD)
+retorna NULL si hubo error */
+static ModeloHuffman modelo_desde_frecuencias(const unsigned long long* frecuencias, int max_longitud) {
+    int profundidad[NUM_CHARS];
+    unsigned char longitudes[NUM_CHARS];
+    int limite = max_longitud > 0 ? max_longitud : CANONICO_MAX_LONGITUD;
+
+    Arena arena = arena_crear(0);
+    CONFIRM_NOTNULL(arena, NULL);
+    int maxima = crear_huffman_lineal(frecuencias, NUM_CHARS, profundidad, arena);
+    int error = maxima < 0;
+    for (int s = 0; s < NUM_CHARS; s++) {
+        longitudes[s] = (unsigned char)profundidad[s];
+    }
+    if (!error && maxima > limite) {
+        error = crear_huffman_limitado(frecuencias, NUM_CHARS, limite, longitudes, arena) != 0;
+    }
+    arena_destruir(arena);
+    return error ? NULL : modelo_desde_longitudes(longitudes);
+}
+
+/* Arma un modelo con las longitudes dadas (codigos y tabla de decodificacion)
+retorna NULL si hubo error */
+static ModeloHuffman modelo_desde_longitudes(const unsigned char* longitudes) {
+    ModeloHuffman m = (ModeloHuffman)malloc(sizeof(struct _ModeloHuffman));
+    CONFIRM_NOTNULL(m, NULL);
+    memcpy(m->longitudes, longitudes, NUM_CHARS);
+    m->max_longitud = 0;
+    for (int s = 0; s < NUM_CHARS; s++) {
+        // un modelo tiene que poder codificar cualquier byte
+        if (longitudes[s] == 0) {
+            free(m);
+            return NULL;
+        }
+        if (longitudes[s] > m->max_longitud) m->max_longitud = longitudes[s];
+    }
+    m->tabla = NULL;
+    if (canonico_codigos(m->longitudes, NUM_CHARS, m->codigos) == 0) {
+        m->tabla = tabladec_crear(m->codigos, m->longitudes, NUM_CHARS, TABLADEC_BITS);
+    }
+    if (m->tabla == NULL) {
+        free(m);
+        return NULL;
+    }
+    return m;
+}
+
+/*====================================================
+     Contextos reutilizables (ver huffman_contexto.h)
+  ====================================================*/
+
+/* Crea un compresor con las opciones dadas (NULL = opciones_defecto)
+retorna NULL si hubo error */
+CompresorHuffman compresor_crear(const OpcionesHuffman* op) {
+    OpcionesHuffman defecto;
+    if (op == NULL) {
+        opciones_defecto(&defecto);
+        op = &defecto;
+    }
+    CONFIRM_TRUE(_opciones_validas(op), NULL);
+    CompresorHuffman c = (CompresorHuffman)calloc(1, sizeof(struct _CompresorHuffman));
+    CONFIRM_NOTNULL(c, NULL);
+    c->op = *op;
+    c->arena = arena_crear(0);
+    if (c->arena == NULL) {
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+/*
+  Comprime los n bytes de datos en salida (de cap bytes).
+  MODO_BLOQUES con op.hilos != 1 usa la tanda del compresor (el pool se crea en
+  la primera llamada), lo demas se hace en este hilo con la arena del compresor.
+  retorna el tamano del resultado, -1 si hubo error o no entra en cap
+*/
+long long compresor_comprimir(CompresorHuffman c, const unsigned char* datos, size_t n, unsigned char* salida, size_t cap) {
+    CONFIRM_NOTNULL(c, -1);
+    CONFIRM_TRUE(datos != NULL || n == 0, -1);
+    CONFIRM_NOTNULL(salida, -1);
+
+    EST_EMPEZAR(est);
+    EST_CONTAR(reservas, 0 - _reservas_arena(c->arena));
+    long long tam;
+    if (c->op.modo == MODO_BLOQUES && c->op.hilos != 1) {
+        Salida s = { NULL, salida, 0, cap };
+        tam = comprimir_bloques(NULL, datos, n, &s, &c->op, &c->tanda) != 0 ? -1 : (long long)s.pos;
+    }
+    else {
+        // lo de la llamada anterior se libera de una vez, la memoria queda en la arena
+        arena_vaciar(c->arena);
+        if (c->op.modo == MODO_BLOQUES) {
+            tam = comprimir_bloques_memoria(datos, n, salida, cap, &c->op, c->arena);
+        }
+        else if (c->op.modo == MODO_CONTEXTO) {
+            tam = comprimir_contexto(datos, n, salida, cap, &c->op, c->arena);
+        }
+        else if (c->op.modo == MODO_SIMBOLOS16) {
+            tam = comprimir_simbolos16(datos, NULL, n, SIMBOLOS_MAX, c->op.max_longitud, salida, cap, c->arena);
+        }
+        else {
+            tam = comprimir_dos_pasadas(datos, n, salida, cap, &c->op, c->arena);
+        }
+    }
+    EST_CONTAR(reservas, _reservas_arena(c->arena));
+    EST_CONTAR(bytes_entrada, n);
+    EST_CONTAR(bytes_salida, tam < 0 ? 0 : (unsigned long long)tam);
+    EST_TERMINAR(est);
+    return tam;
+}
+
+/* Vacia la memoria de trabajo y si op no es NULL cambia las opciones
+retorna 0 si no hay errores */
+int compresor_reiniciar(CompresorHuffman c, const OpcionesHuffman* op) {
+    CONFIRM_NOTNULL(c, 1);
+    if (op != NULL) {
+        CONFIRM_TRUE(_opciones_validas(op), 1);
+        // otra cantidad de hilos necesita otro pool
+        if (op->hilos != c->op.hilos) tanda_liberar(&c->tanda);
+        c->op = *op;
+    }
+    arena_vaciar(c->arena);
+    for (int i = 0; i < c->tanda.num * c->tanda.ranuras; i++) {
+        arena_vaciar(c->tanda.trabajos[i].arena);
+    }
+    return 0;
+}
+
+/* Libera el compresor */
+void compresor_destruir(CompresorHuffman c) {
+    if (c == NULL) return;
+    tanda_liberar(&c->tanda);
+    arena_destruir(c->arena);
+    free(c);
+}
+
+/* Crea un descompresor que decodifica los bloques con hilos hilos (0 = uno por procesador)
+retorna NULL si hubo error */
+DescompresorHuffman descompresor_crear(int hilos) {
+    CONFIRM_TRUE(hilos >= 0, NULL);
+    DescompresorHuffman d = (DescompresorHuffman)calloc(1, sizeof(struct _DescompresorHuffman));
+    CONFIRM_NOTNULL(d, NULL);
+    d->hilos = hilos;
+    d->cache.tabla = NULL;
+    d->arena = arena_crear(0);
+    if (d->arena == NULL) {
+        free(d);
+        return NULL;
+    }
+    return d;
+}
+
+/*
+  Descomprime los tam bytes de datos en salida (de cap bytes).
+  Si el mensaje (o cada bloque) trae las mismas longitudes que el anterior,
+  la tabla de decodificacion no se vuelve a armar.
+  retorna el tamano descomprimido, -1 si hubo error o no entra en cap
+*/
+long long descompresor_descomprimir(DescompresorHuffman d, const unsigned char* datos, size_t tam, unsigned char* salida, size_t cap) {
+    CONFIRM_NOTNULL(d, -1);
+    CONFIRM_TRUE(datos != NULL && tam > 0, -1);
+    CONFIRM_TRUE(salida != NULL || cap == 0, -1);
+
+    EST_EMPEZAR(est);
+    EST_CONTAR(reservas, 0 - _reservas_arena(d->arena));
+    // el lector va en el stack, lee directamente de datos
+    struct _BitReader lector;
+    BitReader in = &lector;
+    InitBitReaderMem(in, datos, tam);
+    int modo = -1;
+    long long cuenta = -1;
+    if (_leer_modo(in, &modo, &cuenta) != 0) {
+        modo = -1;
+    }
+    long long resultado = -1;
+    if (modo == MODO_BLOQUES && d->hilos != 1) {
+        Salida s = { NULL, salida, 0, cap };
+        resultado = descomprimir_bloques(in, &s, d->hilos, &d->tanda) != 0 ? -1 : (long long)s.pos;
+    }
+    else if (modo == MODO_BLOQUES) {
+        resultado = descomprimir_bloques_memoria(in, salida, cap, &d->cache, d->arena);
+    }
+    else if (modo == MODO_ARBOL || modo == MODO_CANONICO) {
+        resultado = descomprimir_dos_pasadas(in, modo, cuenta, salida, cap, &d->cache, d->arena);
+    }
+    else if (modo == MODO_CONTEXTO) {
+        resultado = descomprimir_contexto(in, cuenta, salida, cap, &d->cache, d->arena);
+    }
+    else if (modo == MODO_SIMBOLOS16) {
+        resultado = descomprimir_simbolos16(in, cuenta, salida, NULL, cap, &d->cache, d->arena);
+    }
+    else if (modo == MODO_CRUDO || modo == MODO_RLE) {
+        resultado = descomprimir_sin_codigos(in, modo, cuenta, salida, cap);
+    }
+    EST_CONTAR(reservas, _reservas_arena(d->arena));
+    EST_CONTAR(bytes_entrada, tam);
+    EST_CONTAR(bytes_salida, resultado < 0 ? 0 : (unsigned long long)resultado);
+    EST_TERMINAR(est);
+    return resultado;
+}
+
+/* Olvida las tablas en cache y vacia la memoria de trabajo */
+void descompresor_reiniciar(DescompresorHuffman d) {
+    CONFIRM_RETURN(d);
+    d->cache.tabla = NULL;
+    arena_vaciar(d->arena);
+    for (int i = 0; i < d->tanda.num * d->tanda.ranuras; i++) {
+        d->tanda.trabajos[i].cache.tabla = NULL;
+        arena_vaciar(d->tanda.trabajos[i].arena);
+    }
+}
+
+/* Libera el descompresor */
+void descompresor_destruir(DescompresorHuffman d) {
+    if (d == NULL) return;
+    tanda_liberar(&d->tanda);
+    arena_destruir(d->arena);
+    free(d);
+}
+
+/*====================================================
+     Lectura por rangos (ver huffman_lector.h)
+  ====================================================*/
+
+/* Abre el archivo comprimido nombre (MODO_BLOQUES con indice)
+retorna NULL si hubo error o el archivo no tiene indice */
+LectorHuffman lector_abrir(char* nombre) {
+    CONFIRM_NOTNULL(nombre, NULL);
+    Mapeo mapa = strcmp(nombre, "-") != 0 ? mapeo_abrir(nombre) : NULL;
+    if (mapa != NULL) {
+        // las lecturas saltan por el archivo, leer de antemano no sirve
+        mapeo_aleatorio(mapa);
+        LectorHuffman l = lector_abrir_memoria(mapa->datos, mapa->tam);
+        if (l == NULL) {
+            fprintf(stderr, "%s no tiene indice de bloques\n", nombre);
+            mapeo_cerrar(mapa);
+            return NULL;
+        }
+        l->mapa = mapa;
+        return l;
+    }
+
+    // sin mapeo se leen la cabecera y el indice, y despues cada bloque con fseek
+    FILE* f = _abrir(nombre, 0);
+    CONFIRM_NOTNULL(f, NULL);
+    LectorHuffman l = NULL;
+    unsigned char cabecera[5];
+    unsigned char pie[8];
+    unsigned char* indice = NULL;
+    long tam = -1;
+    if (_leer_completo(f, cabecera, 5) == 5 && fseek(f, -8, SEEK_END) == 0 && (tam = ftell(f)) >= 0 &&
+        _leer_completo(f, pie, 8) == 8 && _leer_u32(pie + 4) == INDICE_MAGIA) {
+        unsigned int num = _leer_u32(pie);
+        tam += 8;
+        if ((unsigned long long)num * 8 <= (unsigned long long)tam &&
+            (indice = (unsigned char*)malloc((size_t)num * 8 + 1)) != NULL &&
+            fseek(f, -8 - (long)num * 8, SEEK_END) == 0 &&
+            _leer_completo(f, indice, (size_t)num * 8) == (size_t)num * 8) {
+            l = _lector_crear(cabecera, indice, num, (unsigned long long)tam);
+        }
+    }
+    free(indice);
+    if (l == NULL) {
+        fprintf(stderr, "%s no tiene indice de bloques\n", nombre);
+        _cerrar(f);
+        return NULL;
+    }
+    l->f = f;
+    return l;
+}
+
+/* Igual que lector_abrir con los tam bytes de datos
+retorna NULL si hubo error o los datos no tienen indice */
+LectorHuffman lector_abrir_memoria(const unsigned char* datos, size_t tam) {
+    CONFIRM_NOTNULL(datos, NULL);
+    if (tam < 5 + 8 || _leer_u32(datos + tam - 4) != INDICE_MAGIA) return NULL;
+    unsigned int num = _leer_u32(datos + tam - 8);
+    if ((unsigned long long)num * 8 > tam - 8) return NULL;
+    LectorHuffman l = _lector_crear(datos, datos + tam - 8 - (size_t)num * 8, num, tam);
+    if (l != NULL) {
+        l->datos = datos;
+    }
+    return l;
+}
+
+/* retorna el tamano de los datos descomprimidos */
+unsigned long long lector_tamano(LectorHuffman l) {
+    CONFIRM_NOTNULL(l, 0);
+    return l->inicio[l->num];
+}
+
+/*
+  Descomprime en salida los n bytes originales que empiezan en desde: busca
+  en el indice el bloque donde empieza el rango y decodifica desde ahi hasta
+  cubrirlo. Los bloques que entran completos se decodifican directamente en
+  salida; los de los bordes en el buffer del lector, que los guarda por si la
+  proxima lectura cae en el mismo bloque.
+
+  retorna los bytes escritos (menos de n si el archivo termina antes), -1 si hubo error
+*/
+long long lector_leer(LectorHuffman l, unsigned long long desde, unsigned char* salida, size_t n) {
+    CONFIRM_NOTNULL(l, -1);
+    CONFIRM_TRUE(salida != NULL || n == 0, -1);
+
+    unsigned long long total = l->inicio[l->num];
+    if (desde >= total) return 0;
+    if (n > total - desde) n = (size_t)(total - desde);
+
+    EST_EMPEZAR(est);
+    // el ultimo bloque que empieza antes o en desde
+    unsigned int i = 0;
+    unsigned int j = l->num;
+    while (j - i > 1) {
+        unsigned int medio = i + (j - i) / 2;
+        if (l->inicio[medio] <= desde) i = medio;
+        else j = medio;
+    }
+
+    size_t hecho = 0;
+    int error = 0;
+    for (; hecho < n && !error; i++) {
+        size_t tam_bloque = (size_t)(l->inicio[i + 1] - l->inicio[i]);
+        size_t salto = (size_t)(desde + hecho - l->inicio[i]);
+        size_t k = tam_bloque - salto < n - hecho ? tam_bloque - salto : n - hecho;
+        if (k == tam_bloque && (long long)i != l->ultimo) {
+            error = _lector_bloque(l, i, salida + hecho);
+        }
+        else {
+            if ((long long)i != l->ultimo) {
+                l->ultimo = -1;
+                error = _crecer((void**)&l->bloque, &l->cap_bloque, tam_bloque) != 0 || _lector_bloque(l, i, l->bloque) != 0;
+                if (!error) l->ultimo = i;
+            }
+            if (!error) memcpy(salida + hecho, l->bloque + salto, k);
+        }
+        hecho += k;
+    }
+    EST_CONTAR(bytes_salida, error ? 0 : hecho);
+    EST_TERMINAR(est);
+    return error ? -1 : (long long)hecho;
+}
+
+/* Libera el lector (y cierra el archivo) */
+void lector_cerrar(LectorHuffman l) {
+    if (l == NULL) return;
+    _cerrar(l->f);
+    mapeo_cerrar(l->mapa);
+    arena_destruir(l->arena);
+    free(l->inicio);
+    free(l->cuerpo);
+    free(l->bloque);
+    free(l);
+}
+
+/*
+  Arma el lector con la cabecera del archivo (5 bytes) y las num entradas del
+  indice. Las posiciones de los bloques en el archivo salen de sumar los tamanos
+  comprimidos, y tienen que terminar justo en el BLOQUE_FIN antes del indice
+  (tam es lo que mide todo el archivo).
+  retorna NULL si el indice no corresponde al archivo
+*/
+static LectorHuffman _lector_crear(const unsigned char* cabecera, const unsigned char* indice, unsigned int num, unsigned long long tam) {
+    if (cabecera[0] != MODO_BLOQUES) return NULL;
+    size_t tam_bloque = _leer_u32(cabecera + 1);
+    if (tam_bloque == 0 || tam_bloque > MAX_TAM_BLOQUE) return NULL;
+
+    LectorHuffman l = (LectorHuffman)calloc(1, sizeof(struct _LectorHuffman));
+    CONFIRM_NOTNULL(l, NULL);
+    l->num = num;
+    l->ultimo = -1;
+    l->cache.tabla = NULL;
+    // inicio y pos en un solo pedido, num + 1 de cada uno
+    l->inicio = (unsigned long long*)malloc(sizeof(unsigned long long) * 2 * ((size_t)num + 1));
+    l->arena = arena_crear(0);
+    if (l->inicio == NULL || l->arena == NULL) {
+        lector_cerrar(l);
+        return NULL;
+    }
+    l->pos = l->inicio + num + 1;
+
+    unsigned long long inicio = 0;
+    unsigned long long pos = 5;
+    for (unsigned int i = 0; i < num; i++) {
+        unsigned int n = _leer_u32(indice + 8 * (size_t)i);
+        if (n > tam_bloque) {
+            lector_cerrar(l);
+            return NULL;
+        }
+        l->inicio[i] = inicio;
+        l->pos[i] = pos;
+        inicio += n;
+        pos += CABECERA_BLOQUE + (unsigned long long)_leer_u32(indice + 8 * (size_t)i + 4);
+    }
+    l->inicio[num] = inicio;
+    l->pos[num] = pos;
+    if (pos + CABECERA_BLOQUE + (unsigned long long)num * 8 + 8 != tam) {
+        lector_cerrar(l);
+        return NULL;
+    }
+    return l;
+}
+
+/* Decodifica el bloque i del lector en destino
+retorna 0 si no hay errores */
+static int _lector_bloque(LectorHuffman l, unsigned int i, unsigned char* destino) {
+    size_t n = (size_t)(l->inicio[i + 1] - l->inicio[i]);
+    size_t tam = (size_t)(l->pos[i + 1] - l->pos[i]);
+    const unsigned char* h = NULL;
+    if (l->datos != NULL) {
+        h = l->datos + l->pos[i];
+    }
+    else {
+        EST_NUEVA_MARCA(m);
+        if (l->pos[i] > LONG_MAX || _crecer((void**)&l->cuerpo, &l->cap_cuerpo, tam) != 0 ||
+            fseek(l->f, (long)l->pos[i], SEEK_SET) != 0 || _leer_completo(l->f, l->cuerpo, tam) != tam) {
+            return 1;
+        }
+        EST_ETAPA(EST_ENTRADA_SALIDA, m);
+        h = l->cuerpo;
+    }
+    EST_CONTAR(bytes_entrada, tam);
+    // la cabecera del bloque tiene que decir lo mismo que el indice
+    if (!BLOQUE_VALIDO(h[0]) || _leer_u32(h + 1) != n ||
+        (size_t)_leer_u32(h + 5) != tam - CABECERA_BLOQUE) {
+        return 1;
+    }
+    return decodificar_bloque(h + CABECERA_BLOQUE, tam - CABECERA_BLOQUE, destino, n, h[0], &l->cache, l->arena);
+}
+
+/*====================================================
+     Estadisticas (ver huffman_estadisticas.h)
+  ====================================================*/
+
+#ifndef HUFFMAN_SIN_ESTADISTICAS
+// lo que midio la ultima llamada que termino en este hilo
+static _LOCAL_HILO EstadisticasHuffman _ultimas;
+#endif
+
+/* Copia en e las estadisticas de la ultima llamada que termino en este hilo */
+void estadisticas_ultimas(EstadisticasHuffman* e) {
+    CONFIRM_RETURN(e);
+#ifndef HUFFMAN_SIN_ESTADISTICAS
+    *e = _ultimas;
+#else
+    memset(e, 0, sizeof(EstadisticasHuffman));
+#endif
+}
+
+/* Escribe e en out como un objeto JSON en una linea
+retorna 0 si no hay errores */
+int estadisticas_json(const EstadisticasHuffman* e, FILE* out) {
+    static const char* nombres[NUM_EST] = {
+        "entrada_salida", "histograma", "arbol", "tabla", "codificar", "decodificar", "total"
+    };
+    CONFIRM_NOTNULL(e, 1);
+    CONFIRM_NOTNULL(out, 1);
+
+    fprintf(out, "{\"etapas\":{");
+    for (int i = 0; i < NUM_EST; i++) {
+        fprintf(out, "%s\"%s\":{\"pared\":%.9f,\"cpu\":%.9f}", i > 0 ? "," : "", nombres[i], e->pared[i], e->cpu[i]);
+    }
+    fprintf(out, "},\"bytes_entrada\":%llu,\"bytes_salida\":%llu,\"simbolos\":%llu,\"bits_codigos\":%llu,"
+        "\"bits_sin_limite\":%llu,\"longitud_media\":%.6f,\"profundidad\":%d,\"bloques\":%llu,\"reservas\":%llu}\n",
+        e->bytes_entrada, e->bytes_salida, e->simbolos, e->bits_codigos,
+        e->bits_sin_limite, e->longitud_media, e->profundidad, e->bloques, e->reservas);
+    return ferror(out) != 0;
+}
+
+#ifndef HUFFMAN_SIN_ESTADISTICAS
+// empieza a medir en e, retorna las de la llamada de afuera (NULL si no hay)
+static EstadisticasHuffman* _est_empezar(EstadisticasHuffman* e) {
+    memset(e, 0, sizeof(EstadisticasHuffman));
+    e->pared[EST_TOTAL] = -benchmark_reloj();
+    e->cpu[EST_TOTAL] = -benchmark_reloj_cpu();
+    EstadisticasHuffman* afuera = _est;
+    _est = e;
+    return afuera;
+}
+
+// termina de medir en e y lo suma a la llamada de afuera
+static void _est_terminar(EstadisticasHuffman* e, EstadisticasHuffman* afuera) {
+    e->pared[EST_TOTAL] += benchmark_reloj();
+    e->cpu[EST_TOTAL] += benchmark_reloj_cpu();
+    e->longitud_media = e->simbolos > 0 ? (double)e->bits_codigos / (double)e->simbolos : 0.0;
+    _est = afuera;
+    if (afuera != NULL) {
+        _est_sumar(afuera, e);
+    }
+    _ultimas = *e;
+}
+
+// suma e a total, el tiempo total de e ya esta dentro del de total
+static void _est_sumar(EstadisticasHuffman* total, const EstadisticasHuffman* e) {
+    for (int i = 0; i < NUM_EST; i++) {
+        if (i == EST_TOTAL) continue;
+        total->pared[i] += e->pared[i];
+        total->cpu[i] += e->cpu[i];
+    }
+    total->bytes_entrada += e->bytes_entrada;
+    total->bytes_salida += e->bytes_salida;
+    total->simbolos += e->simbolos;
+    total->bits_codigos += e->bits_codigos;
+    total->bits_sin_limite += e->bits_sin_limite;
+    if (e->profundidad > total->profundidad) total->profundidad = e->profundidad;
+    total->bloques += e->bloques;
+    total->reservas += e->reservas;
+}
+
+// en un hilo del pool se mide en las del trabajo, retorna las que habia en el hilo
+static EstadisticasHuffman* _est_trabajo(TrabajoBloque* b) {
+    memset(&b->est, 0, sizeof(EstadisticasHuffman));
+    EstadisticasHuffman* afuera = _est;
+    _est = &b->est;
+    b->est.reservas = 0 - _reservas_arena(b->arena);
+    return afuera;
+}
+
+static void _est_fin_trabajo(TrabajoBloque* b, EstadisticasHuffman* afuera) {
+    b->est.reservas += _reservas_arena(b->arena);
+    _est = afuera;
+}
+
+// suma lo que midio cada trabajo de la tanda a la llamada de este hilo
+static void _est_sumar_tanda(const TrabajoBloque* tanda, int n) {
+    if (_est == NULL) return;
+    for (int i = 0; i < n; i++) {
+        _est_sumar(_est, &tanda[i].est);
+    }
+}
+
+static void _marcar(Marca* m) {
+    if (_est == NULL) return;
+    m->pared = benchmark_reloj();
+    m->cpu = benchmark_reloj_cpu();
+}
+
+// suma a la etapa el tiempo desde la marca y la mueve a ahora
+static void _sumar_etapa(int etapa, Marca* m) {
+    if (_est == NULL) return;
+    double pared = benchmark_reloj();
+    double cpu = benchmark_reloj_cpu();
+    _est->pared[etapa] += pared - m->pared;
+    _est->cpu[etapa] += cpu - m->cpu;
+    m->pared = pared;
+    m->cpu = cpu;
+}
+#endif
+
+/*====================================================
+     Medicion de etapas (ver benchmark.h)
+  ====================================================*/
+
+/*
+  Mide cada etapa de comprimir y descomprimir en MODO_ARBOL por separado, con
+  los datos en memoria: el histograma (lo que hace calcular_frecuencias con el
+  archivo), crear_huffman, crear_tabla, codificar y la decodificacion (leer el
+  arbol, armar la tabla y decodificar_memoria). Cada etapa usa el resultado de
+  la anterior, como en comprimir y descomprimir.
+  retorna 0 si no hay errores
+*/
+int huffman_medir_etapas(const unsigned char* datos, size_t n, int repeticiones, MedicionBenchmark* etapas) {
+    CONFIRM_NOTNULL(etapas, 1);
+    memset(etapas, 0, NUM_ETAPAS * sizeof(MedicionBenchmark));
+    CONFIRM_TRUE(datos != NULL || n == 0, 1);
+    CONFIRM_TRUE(repeticiones > 0, 1);
+
+    size_t cap = comprimir_cota(n, NULL);
+    unsigned char* comprimido = malloc(cap);
+    unsigned char* salida = malloc(n > 0 ? n : 1);
+    Arena arena = arena_crear(0);
+    int error = comprimido == NULL || salida == NULL || arena == NULL;
+
+    for (int r = 0; r < repeticiones && !error; r++) {
+        double inicio[NUM_ETAPAS], fin[NUM_ETAPAS];
+        unsigned long long c_inicio[NUM_ETAPAS], c_fin[NUM_ETAPAS];
+        unsigned long long frecuencias[NUM_CHARS] = {0};
+        ArbolPlano arbol;
+        campobits tabla[NUM_CHARS];
+        campobits bits = { 0, 0 };
+        int profundidad[NUM_CHARS] = {0};
+        unsigned char longitudes[NUM_CHARS];
+        arena_vaciar(arena);
+
+        inicio[ETAPA_FRECUENCIAS] = benchmark_reloj();
+        c_inicio[ETAPA_FRECUENCIAS] = benchmark_ciclos();
+        histograma_contar(datos, n, frecuencias);
+        fin[ETAPA_FRECUENCIAS] = benchmark_reloj();
+        c_fin[ETAPA_FRECUENCIAS] = benchmark_ciclos();
+        inicio[ETAPA_ARBOL] = benchmark_reloj();
+        c_inicio[ETAPA_ARBOL] = benchmark_ciclos();
+        error = crear_huffman(frecuencias, &arbol, arena) != 0;
+        fin[ETAPA_ARBOL] = benchmark_reloj();
+        c_fin[ETAPA_ARBOL] = benchmark_ciclos();
+        if (error) break;
+        memset(tabla, 0, sizeof(tabla));
+        inicio[ETAPA_TABLA] = benchmark_reloj();
+        c_inicio[ETAPA_TABLA] = benchmark_ciclos();
+        crear_tabla(tabla, &arbol, arbol.raiz, &bits);
+        fin[ETAPA_TABLA] = benchmark_reloj();
+        c_fin[ETAPA_TABLA] = benchmark_ciclos();
+
+        // las longitudes no son una etapa aparte: codificar las necesita para la cabecera
+        if (calcular_longitudes(&arbol, arbol.raiz, 0, profundidad) > CANONICO_MAX_LONGITUD) {
+            error = 1;
+            break;
+        }
+        for (int i = 0; i < NUM_CHARS; i++) {
+            longitudes[i] = (unsigned char)profundidad[i];
+        }
+        struct _BitWriter escritor;
+        InitBitWriterMem(&escritor, comprimido, cap);
+        inicio[ETAPA_CODIFICAR] = benchmark_reloj();
+        c_inicio[ETAPA_CODIFICAR] = benchmark_ciclos();
+        error = codificar(&arbol, longitudes, datos, n, &escritor, MODO_ARBOL) != 0;
+        long long tam = FlushBitWriterMem(&escritor);
+        fin[ETAPA_CODIFICAR] = benchmark_reloj();
+        c_fin[ETAPA_CODIFICAR] = benchmark_ciclos();
+        if (error || tam < 0) {
+            error = 1;
+            break;
+        }
+
+        // descomprimir: cabecera, arbol, tabla de decodificacion y los codigos
+        inicio[ETAPA_DECODIFICAR] = benchmark_reloj();
+        c_inicio[ETAPA_DECODIFICAR] = benchmark_ciclos();
+        struct _BitReader lector;
+        InitBitReaderMem(&lector, comprimido, (size_t)tam);
+        int modo = 0;
+        long long cuenta = -1;
+        ArbolPlano leido;
+        TablaDec tabladec = NULL;
+        size_t decodificados = 0;
+        if (_leer_modo(&lector, &modo, &cuenta) == 0 && cuenta == (long long)n && n > 0 && leer_arbol(&lector, &leido) == 0) {
+            tabladec = tabla_desde_arbol(&leido, arena);
+        }
+        if (tabladec != NULL) {
+            decodificados = decodificar_memoria(&lector, tabladec, salida, n);
+        }
+        fin[ETAPA_DECODIFICAR] = benchmark_reloj();
+        c_fin[ETAPA_DECODIFICAR] = benchmark_ciclos();
+        error = decodificados != n || (n > 0 && memcmp(datos, salida, n) != 0);
+
+        for (int e = 0; e < NUM_ETAPAS; e++) {
+            double segundos = fin[e] - inicio[e];
+            if (r == 0 || segundos < etapas[e].segundos) {
+                etapas[e].segundos = segundos;
+                etapas[e].ciclos = c_fin[e] - c_inicio[e];
+            }
+        }
+    }
+
+    arena_destruir(arena);
+    free(salida);
+    free(comprimido);
+    return error;
+}
+
+/* Abre un archivo en modo binario, "-" es stdin o stdout
+retorna NULL si hubo error */
+static FILE* _abrir(char* nombre, int escribir) {
+    if (strcmp(nombre, "-") == 0) {
+        FILE* f = escribir ? stdout : stdin;
+#ifdef _WIN32
+        _setmode(_fileno(f), _O_BINARY);
+#endif
+        return f;
+    }
+    FILE* f = fopen(nombre, escribir ? "wb" : "rb");
+    if (f == NULL) {
+        perror("Error al abrir el archivo");
+    }
+    else if (escribir) {
+        // la salida siempre se escribe de a bloques grandes, directo con write
+        setvbuf(f, NULL, _IONBF, 0);
+    }
+    return f;
+}
+
+/* Cierra un archivo abierto con _abrir (stdin y stdout no se cierran) */
+static void _cerrar(FILE* f) {
+    if (f == NULL) return;
+    if (f == stdin) return;
+    if (f == stdout) {
+        fflush(f);
+        return;
+    }
+    fclose(f);
+}
+
+/* Lee hasta n bytes, aunque un pipe los entregue de a partes
+retorna menos de n solo al final del archivo */
+static size_t _leer_completo(FILE* f, unsigned char* buf, size_t n) {
+    size_t total = 0;
+    while (total < n) {
+        size_t leidos = fread(buf + total, 1, n - total, f);
+        if (leidos == 0) break;
+        total += leidos;
+    }
+    return total;
+}
+
+/* Lee el archivo completo a un bloque de memoria nuevo (para cuando no se puede mapear)
+retorna NULL si hubo error */
+static unsigned char* _leer_archivo(char* nombre, size_t* tam) {
+    FILE* f = _abrir(nombre, 0);
+    if (f == NULL) return NULL;
+    size_t cap = BITIO_BUFFER;
+    size_t n = 0;
+    unsigned char* buf = malloc(cap);
+    while (buf != NULL) {
+        n += _leer_completo(f, buf + n, cap - n);
+        if (n < cap) break;
+        unsigned char* nuevo = realloc(buf, cap * 2);
+        if (nuevo == NULL) {
+            free(buf);
+            buf = NULL;
+            break;
+        }
+        buf = nuevo;
+        cap *= 2;
+    }
+    if (buf != NULL && ferror(f)) {
+        free(buf);
+        buf = NULL;
+    }
+    _cerrar(f);
+    *tam = n;
+    return buf;
+}
+
+/* Escribe n bytes en el destino (si ya estan en su lugar en memoria no se copian)
+retorna 0 si no hay errores */
+static int _escribir(Salida* s, const void* p, size_t n) {
+    if (s->f != NULL) {
+        s->pos += n;
+        return fwrite(p, 1, n, s->f) != n;
+    }
+    if (n > s->cap - s->pos) return 1;
+    if (p != s->buf + s->pos) memcpy(s->buf + s->pos, p, n);
+    s->pos += n;
+    return 0;
+}
+
+/* Agranda el arreglo *p (de *cap bytes) para que tenga al menos tam bytes, al menos al doble
+retorna 0 si no hay errores */
+static int _crecer(void** p, size_t* cap, size_t tam) {
+    if (tam <= *cap) return 0;
+    size_t nueva = *cap * 2 > tam ? *cap * 2 : tam;
+    void* nuevo = realloc(*p, nueva);
+    if (nuevo == NULL) return 1;
+    *p = nuevo;
+    *cap = nueva;
+    return 0;
+}
+
+/* Escribe n de a 7 bits por byte, el bit alto indica que sigue otro (a lo sumo MAX_TAM_VARIABLE bytes) */
+static void _escribir_cuenta(BitWriter out, unsigned long long n) {
+    do {
+        unsigned long long b = n & 0x7F;
+        n >>= 7;
+        PutBits(out, n != 0 ? b | 0x80 : b, 8);
+    } while (n != 0);
+}
+
+/* Lee un numero escrito con _escribir_cuenta
+retorna 0 si no hay errores */
+static int _leer_cuenta(BitReader in, unsigned long long* n) {
+    *n = 0;
+    for (int i = 0; i < MAX_TAM_VARIABLE; i++) {
+        if (FillBits(in) < 8) return 1;
+        unsigned long long b = GetBits(in, 8);
+        *n |= (b & 0x7F) << (7 * i);
+        if ((b & 0x80) == 0) return 0;
+    }
+    return 1;
+}
+
+/* Lee el byte de modo y la cantidad de caracteres si la tiene (MODO_CON_CUENTA),
+si no cuenta queda en -1. retorna 0 si no hay errores */
+static int _leer_modo(BitReader in, int* modo, long long* cuenta) {
+    if (FillBits(in) < 8) return 1;
+    int byte = (int)GetBits(in, 8);
+    *modo = byte & ~MODO_CON_CUENTA;
+    *cuenta = -1;
+    if ((byte & MODO_CON_CUENTA) != 0) {
+        unsigned long long n = 0;
+        if (_leer_cuenta(in, &n) != 0 || n > LLONG_MAX) return 1;
+        *cuenta = (long long)n;
+    }
+    return 0;
+}
+
+/* retorna 1 si las opciones son validas para comprimir */
+static int _opciones_validas(const OpcionesHuffman* op) {
+    if (op->modo != MODO_ARBOL && op->modo != MODO_CANONICO && op->modo != MODO_BLOQUES && op->modo != MODO_CONTEXTO && op->modo != MODO_SIMBOLOS16) return 0;
+    if (op->max_longitud < 0 || op->max_longitud > CANONICO_MAX_LONGITUD) return 0;
+    if (op->constructor != CONSTRUCTOR_PQ && op->constructor != CONSTRUCTOR_LINEAL) return 0;
+    if (op->modo == MODO_ARBOL) {
+        // el limite de longitud solo se puede guardar con longitudes canonicas
+        // y el constructor lineal no arma un arbol, solo da longitudes
+        return op->max_longitud == 0 && op->constructor == CONSTRUCTOR_PQ;
+    }
+    if (op->modo == MODO_BLOQUES) {
+        return op->tam_bloque > 0 && op->tam_bloque <= MAX_TAM_BLOQUE && op->hilos >= 0 && (op->flujos == 1 || op->flujos == 4);
+    }
+    return 1;
+}
+
+/* enteros de 4 bytes en little endian */
+static void _poner_u32(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static unsigned int _leer_u32(const unsigned char* p) {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+// llamadas a malloc que lleva hechas la arena
+static unsigned long long _reservas_arena(Arena a) {
+    ArenaEstadisticas e;
+    arena_estadisticas(a, &e);
+    return e.reservas;
+}
+
+/* Longitudes de una tabla con las frecuencias f (num_simbolos), como MODO_CANONICO:
+el constructor lineal y el limitado si pasa de limite. Un solo simbolo queda
+con longitud 1 (ninguno, todas en 0). La memoria sale de la arena
+retorna 0 si no hay errores */
+static int _longitudes_tabla(const unsigned long long* f, int num_simbolos, int limite, unsigned char* l, Arena arena) {
+    int* profundidad = arena_pedir(arena, sizeof(int) * num_simbolos);
+    CONFIRM_NOTNULL(profundidad, 1);
+    int maxima = crear_huffman_lineal(f, num_simbolos, profundidad, arena);
+    CONFIRM_TRUE(maxima >= 0, 1);
+    int usados = 0;
+    for (int s = 0; s < num_simbolos; s++) {
+        l[s] = (unsigned char)profundidad[s];
+        if (f[s] > 0) {
+            usados++;
+            if (usados == 1 && maxima == 0) l[s] = 1;
+        }
+    }
+    if (maxima > limite) {
+        return crear_huffman_limitado(f, num_simbolos, limite, l, arena);
+    }
+    return 0;
+}
+
+/* retorna los bits de los codigos de f con las longitudes l (256), ULLONG_MAX si
+algun simbolo de f no tiene codigo. Con un solo simbolo los codigos no ocupan bits */
+static unsigned long long _costo_tabla(const unsigned long long* f, const unsigned char* l) {
+    if (_simbolos_usados(l) == 1) {
+        for (int s = 0; s < NUM_CHARS; s++) {
+            if (f[s] > 0 && l[s] == 0) return ULLONG_MAX;
+        }
+        return 0;
+    }
+    unsigned long long bits = 0;
+    for (int s = 0; s < NUM_CHARS; s++) {
+        if (f[s] == 0) continue;
+        if (l[s] == 0) return ULLONG_MAX;
+        bits += f[s] * l[s];
+    }
+    return bits;
+}
+
+/* retorna los bits que ocupan las longitudes l (256) escritas con canonico_escribir */
+static unsigned long long _bits_cabecera(const unsigned char* l) {
+    unsigned char buf[MAX_CABECERA];
+    struct _BitWriter escritor;
+    InitBitWriterMem(&escritor, buf, sizeof(buf));
+    canonico_escribir(&escritor, l, NUM_CHARS);
+    return (unsigned long long)escritor.pos * 8 + (unsigned long long)escritor.n;
+}
+
+/* Suma en suma[256] las frecuencias de los contextos c con elegidos[c] != 0
+retorna el total */
+static unsigned long long _sumar_contextos(const unsigned long long* frecuencias, const unsigned char* elegidos, unsigned long long* suma) {
+    unsigned long long total = 0;
+    memset(suma, 0, sizeof(unsigned long long) * NUM_CHARS);
+    for (int c = 0; c < NUM_CHARS; c++) {
+        if (!elegidos[c]) continue;
+        for (int s = 0; s < NUM_CHARS; s++) {
+            suma[s] += frecuencias[(size_t)c * NUM_CHARS + s];
+            total += frecuencias[(size_t)c * NUM_CHARS + s];
+        }
+    }
+    return total;
+}
+
+/* retorna la cantidad de simbolos con longitud (256) */
+static int _simbolos_usados(const unsigned char* l) {
+    int usados = 0;
+    for (int s = 0; s < NUM_CHARS; s++) {
+        if (l[s] > 0) usados++;
+    }
+    return usados;
+}
+
+/* retorna los bits que hacen falta para escribir v (al menos 1) */
+static int _ancho_bits(unsigned int v) {
+    int ancho = 1;
+    while (v >> ancho) ancho++;
+    return ancho;
+}
+
+/* retorna los k simbolos que empiezan en la muestra i: los de simbolos, o si es
+NULL los que se arman en tramo con los bytes de datos (little endian) */
+static const unsigned short* _muestras(const unsigned char* datos, const unsigned short* simbolos, size_t i, size_t k, unsigned short* tramo) {
+    if (simbolos != NULL) return simbolos + i;
+    const unsigned char* p = datos + 2 * i;
+    for (size_t j = 0; j < k; j++) {
+        tramo[j] = (unsigned short)(p[2 * j] | (p[2 * j + 1] << 8));
+    }
+    return tramo;
+}
+
+/* Escribe los k simbolos en datos, 2 bytes cada uno (little endian) */
+static void _bytes_muestras(const unsigned short* simbolos, size_t k, unsigned char* datos) {
+    for (size_t j = 0; j < k; j++) {
+        datos[2 * j] = (unsigned char)simbolos[j];
+        datos[2 * j + 1] = (unsigned char)(simbolos[j] >> 8);
+    }
+}
+
+static int _es_hoja(const ArbolPlano* T, int nodo) {
+    CONFIRM_NOTNULL(T, -1);
+    return T->nodos[nodo].izq == HOJA;
+}
+
+static void _escribir_arbol(const ArbolPlano* T, int nodo, BitWriter out) {
+    CONFIRM_RETURN(T);
+    CONFIRM_RETURN(out);
+    // si el nodo es una hoja ponemos un 1 y el byte del caracter
+    if (_es_hoja(T, nodo)) {
+        PutBits(out, 1, 1);
+        PutBits(out, (unsigned char)T->nodos[nodo].der, 8);
+    }
+    else { // si no ponemos un 0 y seguimos en preorden
+        PutBits(out, 0, 1);
+        _escribir_arbol(T, T->nodos[nodo].izq, out);
+        _escribir_arbol(T, T->nodos[nodo].der, out);
+    }
+}
+
+// funcion usada para reconstruir el arbol
+// lee un nodo en preorden y lo agrega al arreglo, retorna su indice o -1 si hay error
+// (un archivo corrupto no puede pasarse de MAX_NODOS ni de la profundidad de un codigo)
+static int _leer_nodo(BitReader bs, ArbolPlano* T, int profundidad) {
+    if (T->num == MAX_NODOS || profundidad > NUM_CHARS) return -1;
+    // leer un bit de bs
+    int bit = IsEmptyBitReader(bs) ? -1 : (int)GetBits(bs, 1);
+    if (bit < 0) return -1; // si hay un error de lectura
+
+    int i = T->num++;
+    if (bit == 1) {
+        // si el bit leido es una hoja debemos leer el ascii
+        T->nodos[i].izq = HOJA;
+        T->nodos[i].der = (short)GetBits(bs, 8);
+        return i;
+    }
+    // leer recursivamente creando nodo izq y der
+    int izq = _leer_nodo(bs, T, profundidad + 1);
+    if (izq < 0) return -1;
+    int der = _leer_nodo(bs, T, profundidad + 1);
+    if (der < 0) return -1;
+    T->nodos[i].izq = (short)izq;
+    T->nodos[i].der = (short)der;
+    return i;
 }
 
 /*
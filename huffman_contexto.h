@@ -0,0 +1,53 @@
+#ifndef DEFINE_HUFFMAN_CONTEXTO_H
+#define DEFINE_HUFFMAN_CONTEXTO_H
+
+#include <stddef.h>
+#include "huffman_opciones.h"
+
+/*Contextos reutilizables de compresion y descompresion, las funciones estan en huffman.c*/
+
+/*
+  Para comprimir o descomprimir muchos mensajes seguidos (por ejemplo en un
+  servidor), un contexto guarda entre llamadas todo lo que comprimir_memoria y
+  descomprimir_memoria arman y liberan en cada una: la arena de trabajo (pq,
+  constructores, tablas), el pool de hilos con sus trabajos y buffers, y la
+  ultima tabla de decodificacion. Despues de las primeras llamadas ya no se pide
+  memoria mientras los mensajes no crezcan.
+  El resultado es el mismo que el de las funciones de memoria.
+  Un contexto no se puede usar desde dos hilos a la vez.
+*/
+
+typedef struct _CompresorHuffman* CompresorHuffman;
+typedef struct _DescompresorHuffman* DescompresorHuffman;
+
+/* Crea un compresor con las opciones dadas (NULL = opciones_defecto)
+retorna NULL si hubo error */
+CompresorHuffman compresor_crear(const OpcionesHuffman* op);
+
+/* Comprime los n bytes de datos en salida (de cap bytes, ver comprimir_cota)
+retorna el tamano del resultado, -1 si hubo error o no entra en cap */
+long long compresor_comprimir(CompresorHuffman c, const unsigned char* datos, size_t n, unsigned char* salida, size_t cap);
+
+/* Vacia la memoria de trabajo (queda reservada) y si op no es NULL cambia las opciones
+retorna 0 si no hay errores */
+int compresor_reiniciar(CompresorHuffman c, const OpcionesHuffman* op);
+
+/* Libera el compresor */
+void compresor_destruir(CompresorHuffman c);
+
+/* Crea un descompresor. hilos decodifican los bloques de MODO_BLOQUES,
+0 = uno por procesador, 1 = todo en el hilo que llama
+retorna NULL si hubo error */
+DescompresorHuffman descompresor_crear(int hilos);
+
+/* Descomprime los tam bytes de datos en salida (de cap bytes)
+retorna el tamano descomprimido, -1 si hubo error o no entra en cap */
+long long descompresor_descomprimir(DescompresorHuffman d, const unsigned char* datos, size_t tam, unsigned char* salida, size_t cap);
+
+/* Olvida la ultima tabla y vacia la memoria de trabajo (queda reservada) */
+void descompresor_reiniciar(DescompresorHuffman d);
+
+/* Libera el descompresor */
+void descompresor_destruir(DescompresorHuffman d);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef DEFINE_HUFFMAN_ESTADISTICAS_H
+#define DEFINE_HUFFMAN_ESTADISTICAS_H
+
+#include <stdio.h>
+
+/*Estadisticas de cada llamada al compresor, las funciones estan en huffman.c*/
+
+/*
+  Cada llamada a comprimir/descomprimir (de archivos, de memoria o con un
+  contexto) mide el tiempo de reloj y de CPU de cada etapa y cuenta bytes,
+  caracteres, bits, bloques y reservas de memoria. Al terminar la llamada,
+  estadisticas_ultimas devuelve lo que se midio en ella. Lo que miden las
+  llamadas de adentro (comprimir_opciones usa comprimir_memoria) se suma a la
+  de afuera.
+
+  El tiempo de CPU es el del hilo. En MODO_BLOQUES con varios hilos, las etapas
+  de cada bloque se suman entre todos los hilos y pueden pasar el tiempo total.
+
+  Compilando con HUFFMAN_SIN_ESTADISTICAS no se mide nada (las marcas quedan
+  vacias) y estadisticas_ultimas devuelve todo en 0.
+*/
+
+/* etapas */
+#define EST_ENTRADA_SALIDA 0  /* leer y escribir archivos */
+#define EST_HISTOGRAMA 1      /* contar las frecuencias */
+#define EST_ARBOL 2           /* arbol o longitudes de los codigos */
+#define EST_TABLA 3           /* tabla de codigos, o leer la cabecera y armar la tabla de decodificacion */
+#define EST_CODIFICAR 4       /* escribir la cabecera y los codigos */
+#define EST_DECODIFICAR 5
+#define EST_TOTAL 6           /* toda la llamada */
+#define NUM_EST 7
+
+typedef struct _EstadisticasHuffman {
+	double pared[NUM_EST];            /* segundos de reloj */
+	double cpu[NUM_EST];              /* segundos de CPU del hilo */
+	unsigned long long bytes_entrada; /* 0 si no se sabe (descomprimir desde stdin) */
+	unsigned long long bytes_salida;
+	unsigned long long simbolos;      /* caracteres codificados o decodificados */
+	unsigned long long bits_codigos;  /* bits de los codigos sin las cabeceras, solo al comprimir */
+	unsigned long long bits_sin_limite; /* bits_codigos con los codigos de huffman sin limitar la longitud (max_longitud),
+	                                       en MODO_CONTEXTO y MODO_SIMBOLOS16 igual a bits_codigos */
+	double longitud_media;            /* bits_codigos / simbolos */
+	int profundidad;                  /* longitud del codigo mas largo */
+	unsigned long long bloques;       /* bloques de MODO_BLOQUES */
+	unsigned long long reservas;      /* llamadas a malloc de las arenas de trabajo */
+} EstadisticasHuffman;
+
+/* Copia en e las estadisticas de la ultima llamada que termino en este hilo */
+void estadisticas_ultimas(EstadisticasHuffman* e);
+
+/* Escribe e en out como un objeto JSON en una linea
+retorna 0 si no hay errores */
+int estadisticas_json(const EstadisticasHuffman* e, FILE* out);
+
+#endif
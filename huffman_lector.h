@@ -0,0 +1,44 @@
+#ifndef DEFINE_HUFFMAN_LECTOR_H
+#define DEFINE_HUFFMAN_LECTOR_H
+
+#include <stddef.h>
+
+/*Lectura por rangos de archivos comprimidos, las funciones estan en huffman.c*/
+
+/*
+  MODO_BLOQUES guarda al final un indice con el tamano original y comprimido de
+  cada bloque: es una marca cada tam_bloque bytes originales con la posicion del
+  bloque en el archivo. Un lector lee el indice una vez al abrir y despues cada
+  lector_leer busca los bloques del rango y decodifica solo esos, asi el costo es
+  el del rango (redondeado a bloques) y no el del archivo. Con bloques chicos
+  (OpcionesHuffman.tam_bloque, por ejemplo 16 KiB) hay menos que decodificar de
+  mas en cada lectura, a cambio de un poco de compresion.
+  El ultimo bloque decodificado queda guardado, las lecturas seguidas dentro del
+  mismo bloque no lo decodifican de nuevo.
+  MODO_ARBOL y MODO_CANONICO son un solo flujo de bits y no se pueden leer por
+  rangos. Un lector no se puede usar desde dos hilos a la vez.
+*/
+
+typedef struct _LectorHuffman* LectorHuffman;
+
+/* Abre el archivo comprimido nombre (MODO_BLOQUES con indice). Si se puede se
+mapea, si no se lee con fseek solo lo que hace falta
+retorna NULL si hubo error o el archivo no tiene indice */
+LectorHuffman lector_abrir(char* nombre);
+
+/* Igual que lector_abrir con los tam bytes de datos, que tienen que seguir
+validos hasta lector_cerrar
+retorna NULL si hubo error o los datos no tienen indice */
+LectorHuffman lector_abrir_memoria(const unsigned char* datos, size_t tam);
+
+/* retorna el tamano de los datos descomprimidos */
+unsigned long long lector_tamano(LectorHuffman l);
+
+/* Descomprime en salida los n bytes originales que empiezan en desde
+retorna los bytes escritos (menos de n si el archivo termina antes), -1 si hubo error */
+long long lector_leer(LectorHuffman l, unsigned long long desde, unsigned char* salida, size_t n);
+
+/* Libera el lector (y cierra el archivo) */
+void lector_cerrar(LectorHuffman l);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef DEFINE_HUFFMAN_MODELO_H
+#define DEFINE_HUFFMAN_MODELO_H
+
+#include <stddef.h>
+
+/*Modelo compartido para mensajes chicos, las funciones estan en huffman.c*/
+
+/*
+  Cuando hay muchos mensajes chicos con casi la misma distribucion de bytes,
+  calcular las frecuencias y escribir un arbol o las longitudes en cada uno
+  cuesta mas que el mensaje. Un modelo se entrena una vez con archivos de
+  ejemplo, se guarda en un archivo y despues cada mensaje se codifica contra
+  el sin cabecera: solo su tamano original (1 a 10 bytes) y los codigos.
+  El modelo guarda los codigos y la tabla de decodificacion ya armados, asi
+  cada llamada no arma nada. Se puede usar desde varios hilos a la vez.
+*/
+
+/* marca al inicio del archivo del modelo ("HMOD" en little endian) */
+#define MODELO_MAGIA 0x444F4D48u
+
+typedef struct _ModeloHuffman* ModeloHuffman;
+
+/*
+  Entrena un modelo con las frecuencias de los num archivos de ejemplo.
+  Todos los bytes reciben un codigo aunque no aparezcan en los ejemplos.
+  max_longitud es la longitud maxima de un codigo (8 a 32), 0 = sin limite
+  retorna NULL si hubo error
+*/
+ModeloHuffman modelo_entrenar(char** archivos, int num, int max_longitud);
+
+/* Guarda el modelo en el archivo nombre
+retorna 0 si no hay errores */
+int modelo_guardar(ModeloHuffman m, char* nombre);
+
+/* Carga un modelo guardado con modelo_guardar
+retorna NULL si hubo error */
+ModeloHuffman modelo_cargar(char* nombre);
+
+/* Libera el modelo */
+void modelo_destruir(ModeloHuffman m);
+
+/* retorna el tamano maximo que puede ocupar un mensaje de n bytes codificado con el modelo */
+size_t modelo_cota(ModeloHuffman m, size_t n);
+
+/* Codifica los n bytes de datos en salida (de cap bytes)
+retorna el tamano del mensaje codificado, -1 si hubo error o no entra en cap */
+long long modelo_comprimir(ModeloHuffman m, const unsigned char* datos, size_t n, unsigned char* salida, size_t cap);
+
+/* Decodifica un mensaje de tam bytes en salida (de cap bytes)
+retorna la cantidad de bytes decodificados, -1 si hubo error o no entran en cap */
+long long modelo_descomprimir(ModeloHuffman m, const unsigned char* datos, size_t tam, unsigned char* salida, size_t cap);
+
+#endif
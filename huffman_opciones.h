@@ -0,0 +1,89 @@
+#ifndef DEFINE_HUFFMAN_OPCIONES_H
+#define DEFINE_HUFFMAN_OPCIONES_H
+
+#include <stddef.h>
+
+/*Opciones del compresor, las funciones que las reciben estan en huffman.c*/
+
+/* formato de la cabecera del archivo comprimido (primer byte del archivo) */
+#define MODO_ARBOL 0     /* arbol de huffman en preorden */
+#define MODO_CANONICO 1  /* solo las longitudes de los codigos canonicos */
+#define MODO_BLOQUES 2   /* una sola pasada, bloques independientes con sus propias longitudes canonicas */
+#define MODO_CONTEXTO 3  /* dos pasadas, el codigo de cada byte depende del anterior (una tabla canonica por grupo de contextos) */
+#define MODO_SIMBOLOS16 4  /* dos pasadas, cada 2 bytes (little endian) son un simbolo de 16 bits (ver huffman_simbolos.h) */
+/* estos dos no son opciones: los elige MODO_ARBOL o MODO_CANONICO cuando los codigos no ganan nada */
+#define MODO_CRUDO 5     /* los datos tal cual, sin codigos (datos ya comprimidos o aleatorios) */
+#define MODO_RLE 6       /* un solo caracter repetido, se guarda una vez */
+
+/* tamano de bloque por defecto en MODO_BLOQUES */
+#define TAM_BLOQUE_DEFECTO (128 * 1024)
+
+/* memoria de trabajo que alcanza para que comprimir_memoria y descomprimir_memoria no pidan memoria
+(salvo MODO_CONTEXTO y MODO_SIMBOLOS16: 512 KiB de conteos mas las tablas, lo que falta se pide con malloc) */
+#define MEMORIA_TRABAJO (512 * 1024)
+
+/* como se calculan las longitudes de los codigos */
+#define CONSTRUCTOR_PQ 0      /* crear_huffman con la cola de prioridad y un Arbol */
+#define CONSTRUCTOR_LINEAL 1  /* dos colas en un arreglo plano, solo MODO_CANONICO */
+
+typedef struct _OpcionesHuffman {
+	int modo;
+	int max_longitud;  /* longitud maxima de un codigo (1 a 32), 0 = sin limite. Solo con MODO_CANONICO, MODO_CONTEXTO y MODO_SIMBOLOS16 */
+	int constructor;
+	int tam_bloque;    /* bytes de entrada por bloque en MODO_BLOQUES */
+	int hilos;         /* hilos que codifican bloques en MODO_BLOQUES, 0 = uno por procesador */
+	int flujos;        /* flujos de bits por bloque en MODO_BLOQUES: 1, o 4 intercalados para decodificar mas rapido */
+} OpcionesHuffman;
+
+/* Llena op con las opciones que usa comprimir() */
+void opciones_defecto(OpcionesHuffman* op);
+
+/*
+  Comprime archivo entrada y lo escribe a archivo salida con las opciones dadas.
+  descomprimir() reconoce cualquiera de los formatos.
+  "-" como entrada o salida es stdin o stdout, la entrada por stdin siempre usa MODO_BLOQUES.
+
+  Retorna 0 si no hay errores.
+*/
+int comprimir_opciones(char* entrada, char* salida, const OpcionesHuffman* op);
+
+/*
+  Variantes de comprimir_opciones y descomprimir que no cargan el archivo en
+  memoria: mientras el pool codifica (o decodifica) una tanda de bloques, un
+  hilo lee la siguiente y otro escribe la anterior, asi el disco y los
+  procesadores trabajan a la vez. La memoria queda fija (tres tandas).
+  comprimir_tuberia siempre usa MODO_BLOQUES; descomprimir_tuberia reconoce
+  cualquier formato pero solo superpone las etapas en MODO_BLOQUES.
+  Retornan 0 si no hay errores.
+*/
+int comprimir_tuberia(char* entrada, char* salida, const OpcionesHuffman* op);
+int descomprimir_tuberia(char* entrada, char* salida);
+
+/*
+  Funciones de memoria a memoria, comprimir_opciones y descomprimir las usan por dentro.
+  El resultado es el mismo que el del archivo. salida tiene cap bytes; si el
+  resultado no entra se retorna -1 (ver comprimir_cota).
+  trabajo es memoria temporal del llamador (tam_trabajo bytes, MEMORIA_TRABAJO alcanza):
+  con trabajo no se pide memoria y todo se hace en el hilo que llama. Sin trabajo
+  (NULL) MODO_BLOQUES usa op->hilos hilos (descomprimir_memoria uno por procesador).
+*/
+
+/* Tamano maximo del resultado de comprimir n bytes con op (NULL = opciones_defecto) */
+size_t comprimir_cota(size_t n, const OpcionesHuffman* op);
+
+/* Comprime los n bytes de datos en salida con op (NULL = opciones_defecto)
+retorna el tamano del resultado, -1 si hubo error */
+long long comprimir_memoria(const unsigned char* datos, size_t n, unsigned char* salida, size_t cap,
+	const OpcionesHuffman* op, void* trabajo, size_t tam_trabajo);
+
+/* Descomprime los tam bytes de datos en salida. Con datos invalidos no escribe nada en stderr
+retorna el tamano descomprimido, -1 si hubo error */
+long long descomprimir_memoria(const unsigned char* datos, size_t tam, unsigned char* salida, size_t cap,
+	void* trabajo, size_t tam_trabajo);
+
+/* Tamano de los tam bytes de datos descomprimidos, sin descomprimirlos
+(la cantidad de caracteres de la cabecera, en MODO_BLOQUES la suma del indice)
+retorna -1 si el archivo no lo guarda */
+long long descomprimir_tamano(const unsigned char* datos, size_t tam);
+
+#endif
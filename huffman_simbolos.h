@@ -0,0 +1,39 @@
+#ifndef DEFINE_HUFFMAN_SIMBOLOS_H
+#define DEFINE_HUFFMAN_SIMBOLOS_H
+
+#include <stddef.h>
+
+/*Alfabetos de hasta 64K simbolos, las funciones estan en huffman.c*/
+
+/*
+  Con muestras de 16 bits o con palabras que se repiten, codificar byte por
+  byte pierde casi toda la ganancia: el codigo de cada byte no sabe nada del
+  otro byte de la muestra. Aca cada simbolo es un numero de 0 a num_simbolos - 1
+  (hasta SIMBOLOS_MAX) y recibe su propio codigo canonico. Las palabras se
+  pasan como su numero en un diccionario del llamador.
+  Solo se guardan las longitudes de los simbolos que aparecen y la tabla de
+  decodificacion crece con los codigos usados, no con el alfabeto.
+  Es el formato de MODO_SIMBOLOS16 (ver huffman_opciones.h): los simbolos
+  comprimidos aca se pueden descomprimir con descomprimir_memoria como bytes
+  (dos por simbolo, little endian) y al reves.
+*/
+
+/* simbolos maximos de un alfabeto */
+#define SIMBOLOS_MAX 65536
+
+/* retorna el tamano maximo del resultado de comprimir n simbolos de un alfabeto de num_simbolos */
+size_t simbolos_cota(size_t n, int num_simbolos);
+
+/*
+  Comprime los n simbolos (cada uno menor que num_simbolos) en salida (de cap bytes).
+  max_longitud es la longitud maxima de un codigo (1 a 32), 0 = sin limite
+  retorna el tamano del resultado, -1 si hubo error o no entra en cap
+*/
+long long comprimir_simbolos(const unsigned short* simbolos, size_t n, int num_simbolos, int max_longitud,
+	unsigned char* salida, size_t cap);
+
+/* Descomprime los tam bytes de datos en salida (de cap simbolos)
+retorna la cantidad de simbolos, -1 si hubo error o no entran en cap */
+long long descomprimir_simbolos(const unsigned char* datos, size_t tam, unsigned short* salida, size_t cap);
+
+#endif
@@ -0,0 +1,92 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "mapeo.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* Mapea el archivo completo para lectura
+retorna NULL si no se puede mapear */
+Mapeo mapeo_abrir(const char* nombre) {
+	if (nombre == NULL) return NULL;
+	Mapeo m = (Mapeo)malloc(sizeof(struct _Mapeo));
+	if (m == NULL) return NULL;
+	m->datos = NULL;
+	m->tam = 0;
+	m->base = NULL;
+
+#ifdef _WIN32
+	m->mapeo = NULL;
+	m->archivo = CreateFileA(nombre, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	LARGE_INTEGER tam;
+	if (m->archivo == INVALID_HANDLE_VALUE || GetFileType(m->archivo) != FILE_TYPE_DISK || !GetFileSizeEx(m->archivo, &tam)) {
+		if (m->archivo != INVALID_HANDLE_VALUE) CloseHandle(m->archivo);
+		free(m);
+		return NULL;
+	}
+	m->tam = (size_t)tam.QuadPart;
+	if (m->tam > 0) { // un archivo vacio no se puede mapear, pero no hay nada que leer
+		m->mapeo = CreateFileMappingA(m->archivo, NULL, PAGE_READONLY, 0, 0, NULL);
+		m->base = m->mapeo != NULL ? MapViewOfFile(m->mapeo, FILE_MAP_READ, 0, 0, 0) : NULL;
+		if (m->base == NULL) {
+			if (m->mapeo != NULL) CloseHandle(m->mapeo);
+			CloseHandle(m->archivo);
+			free(m);
+			return NULL;
+		}
+	}
+#else
+	int fd = open(nombre, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		if (fd >= 0) close(fd);
+		free(m);
+		return NULL;
+	}
+	m->tam = (size_t)st.st_size;
+	if (m->tam > 0) { // un archivo vacio no se puede mapear, pero no hay nada que leer
+		void* base = mmap(NULL, m->tam, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (base == MAP_FAILED) {
+			close(fd);
+			free(m);
+			return NULL;
+		}
+		m->base = base;
+#ifdef MADV_SEQUENTIAL
+		madvise(base, m->tam, MADV_SEQUENTIAL);
+#endif
+	}
+	close(fd); // el mapeo sigue valido sin el descriptor
+#endif
+
+	m->datos = (const unsigned char*)m->base;
+	return m;
+}
+
+/* Avisa que el mapeo se va a leer salteado */
+void mapeo_aleatorio(Mapeo m) {
+	if (m == NULL || m->base == NULL) return;
+#if !defined(_WIN32) && defined(MADV_RANDOM)
+	madvise(m->base, m->tam, MADV_RANDOM);
+#endif
+}
+
+/* Libera el mapeo */
+void mapeo_cerrar(Mapeo m) {
+	if (m == NULL) return;
+#ifdef _WIN32
+	if (m->base != NULL) UnmapViewOfFile(m->base);
+	if (m->mapeo != NULL) CloseHandle(m->mapeo);
+	CloseHandle(m->archivo);
+#else
+	if (m->base != NULL) munmap(m->base, m->tam);
+#endif
+	free(m);
+}
@@ -0,0 +1,36 @@
+#ifndef DEFINE_MAPEO_H
+#define DEFINE_MAPEO_H
+
+#include <stddef.h>
+
+/*Definicion del API para leer un archivo mapeado en memoria, la implementacion va en mapeo.c*/
+
+/*
+  Un Mapeo deja el contenido de un archivo en memoria sin copiarlo:
+  el compresor y el descompresor lo leen directamente, sin pasar por
+  los buffers de stdio. Usa mmap (con madvise MADV_SEQUENTIAL porque
+  se recorre de principio a fin) o MapViewOfFile en Windows.
+  Los pipes y lo que no se puede mapear se siguen leyendo con FILE*.
+*/
+typedef struct _Mapeo {
+	const unsigned char* datos;
+	size_t tam;
+	void* base;     /* lo que hay que liberar, NULL si el archivo esta vacio */
+#ifdef _WIN32
+	void* archivo;  /* HANDLE del archivo y del mapeo */
+	void* mapeo;
+#endif
+}*Mapeo;
+
+/* Mapea el archivo completo para lectura
+retorna NULL si no se puede mapear (no existe, es un pipe, etc.) */
+Mapeo mapeo_abrir(const char* nombre);
+
+/* Avisa que el mapeo se va a leer salteado (ver huffman_lector.h): sin MADV_SEQUENTIAL
+no se lee de antemano lo que sigue a cada pagina. En Windows no hace nada */
+void mapeo_aleatorio(Mapeo m);
+
+/* Libera el mapeo */
+void mapeo_cerrar(Mapeo m);
+
+#endif
@@ -1,9 +1,13 @@
 #define _CRT_SECURE_NO_WARNINGS
 #define INITIAL_CAP 256
+#define LINEA_CACHE 64
 #include "pq.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
+static BOOLEAN _agrandar(PQ pq, int minimo);
+static struct _PrioValue* _alinear(void* mem);
 
 /* Crea la cola de prioridad PQ e inicializa sus atributos
 retorna un puntero a la cola de prioridad 
@@ -14,16 +18,31 @@ PQ pq_create() {
 	if (pq == NULL) return NULL;
 
 	// crear el array y verificar su creacion
-	PrioValue *arr = malloc(sizeof(struct _PrioValue) * INITIAL_CAP);
-	if (arr == NULL) {
+	pq->mem = NULL;
+	pq->arr = NULL;
+	pq->cap = 0;
+	pq->size = 0;
+	pq->arena = NULL;
+	if (!_agrandar(pq, INITIAL_CAP)) {
 		free(pq);
 		return NULL;
 	}
+	return pq;
+}
 
-	// asignar valores
-	pq->arr = arr;
-	pq->cap = INITIAL_CAP;
+/* Como pq_create pero toda la memoria de la cola se pide a la arena
+retorna NULL si hubo error*/
+PQ pq_create_arena(Arena arena) {
+	if (arena == NULL) return NULL;
+	PQ pq = (PQ)arena_pedir(arena, sizeof(struct Heap));
+	if (pq == NULL) return NULL;
+
+	pq->mem = NULL;
+	pq->arr = NULL;
+	pq->cap = 0;
 	pq->size = 0;
+	pq->arena = arena;
+	if (!_agrandar(pq, INITIAL_CAP)) return NULL;
 	return pq;
 }
 
@@ -39,45 +58,57 @@ BOOLEAN pq_add(PQ pq, void* valor, int prioridad, int es_arbol) {
 	if (prioridad < 0) return FALSE; // se puede usar prioridad negativa???
 
 	// verificar si pq esta lleno, si es asi, agrandar
-	if (pq->size == pq->cap) { return FALSE; }
-
-	// crear estructura PrioValue y verificar creacin
-	PrioValue pv = (PrioValue)malloc(sizeof(struct _PrioValue));
-	if (pv == NULL) return FALSE;
-	// asignarle los valores
-	pv->value = valor;
-	pv->prio = prioridad;
-	pv->es_arbol = es_arbol;
-
-	// poner en el ndice size + 1 y aumentar el size; luego propagar arriba
-	int newIndex = pq->size + 1;
-	pq->arr[newIndex] = pv;
-	pq->size = newIndex;
+	if (pq->size == pq->cap && !_agrandar(pq, pq->size + 1)) return FALSE;
+
+	// poner al final del arreglo (sin malloc, el PrioValue vive en el arreglo) y propagar arriba
+	int newIndex = pq->size;
+	pq->arr[newIndex].value = valor;
+	pq->arr[newIndex].prio = prioridad;
+	pq->arr[newIndex].es_arbol = es_arbol;
+	pq->size++;
 	_percolate_up(pq, newIndex);
 
-	//printf("Se agrego valor %c con prioridad %d\n", *(char*)pv->value, prioridad);
 	return TRUE;
 }
 
 /* 
-  Saca el valor de menor prioridad (cima del monticulo) y lo guarda en la posicion retVal (paso por referencia)
-  retorna FALSE si tiene un error
+  Saca el valor de menor prioridad (cima del monticulo) y copia su PrioValue en retVal (paso por referencia)
+  retorna FALSE si tiene un error o si la cola esta vacia
   retorna TRUE si tuvo EXITO
 */
-BOOLEAN pq_remove(PQ pq, void** retVal) {
+BOOLEAN pq_remove(PQ pq, PrioValue retVal) {
 	if (pq == NULL || retVal == NULL) return FALSE;
+	if (pq->size == 0) return FALSE;
 
-	// Guardar el nodo que ser eliminado
-	PrioValue toRemove = pq->arr[1];
-	// Devolver el puntero al nodo
-	*retVal = toRemove;
+	// copiar el nodo que ser eliminado
+	*retVal = pq->arr[0];
 
 	// poner el ultimo elemento en la cima
-	pq->arr[1] = pq->arr[pq->size];
+	pq->arr[0] = pq->arr[pq->size - 1];
 	// decrementar el tamao
 	pq->size--;
 	// propagar hacia abajo
-	_percolate_down(pq, 1);
+	_percolate_down(pq, 0);
+	return TRUE;
+}
+
+/*
+Agrega n elementos de una vez y reordena todo el monticulo en O(n)
+retorna TRUE si tuvo exito, FALSE si no
+*/
+BOOLEAN pq_heapify(PQ pq, const struct _PrioValue* elementos, int n) {
+	if (pq == NULL || n < 0 || (elementos == NULL && n > 0)) return FALSE;
+	if (pq->size + n > pq->cap && !_agrandar(pq, pq->size + n)) return FALSE;
+
+	memcpy(pq->arr + pq->size, elementos, sizeof(struct _PrioValue) * n);
+	pq->size += n;
+
+	// propagar abajo desde el ultimo padre hasta la cima (Floyd)
+	if (pq->size > 1) {
+		for (int i = (pq->size - 2) / PQ_ARIDAD; i >= 0; i--) {
+			_percolate_down(pq, i);
+		}
+	}
 	return TRUE;
 }
 
@@ -95,32 +126,31 @@ retorna FALSE si tuvo error*/
 BOOLEAN pq_destroy(PQ pq) {
 	if (pq == NULL) return FALSE;
 
-	// liberar los nodos
-	for (int i = 1; i <= pq->size; i++) {
-		free(pq->arr[i]);
-	}
-	// liberar array y pq
-	free(pq->arr);
+	// los nodos estan dentro del array, alcanza con liberar array y pq
+	// (si son de una arena se liberan con ella)
+	if (pq->arena != NULL) return TRUE;
+	free(pq->mem);
 	free(pq);
 	return TRUE;
 }
 
 // FUNCIONES ADICIONALES AGREGADAS -----------
 
-/* Realiza la operacion de propagar arriba*/
+/* Realiza la operacion de propagar arriba
+se mueve el hueco hacia arriba en vez de intercambiar en cada nivel */
 void _percolate_up(PQ pq, int i) {
-	if (pq == NULL || i <= 1) return; // caso base
-
-	// calcular el padre
-	int pa = i / 2;
-
-	// si el padre tiene mayor prioridad que el nuevo, intercambiar y propagar arriba recursivamente
-	if (pq->arr[pa]->prio > pq->arr[i]->prio) {
-		PrioValue temp = pq->arr[pa];
-		pq->arr[pa] = pq->arr[i];
-		pq->arr[i] = temp;
-		_percolate_up(pq, pa);
+	if (pq == NULL || i <= 0) return; // caso base
+
+	struct _PrioValue nuevo = pq->arr[i];
+	while (i > 0) {
+		// calcular el padre
+		int pa = (i - 1) / PQ_ARIDAD;
+		// si el padre tiene mayor prioridad que el nuevo, bajar el padre y seguir subiendo
+		if (pq->arr[pa].prio <= nuevo.prio) break;
+		pq->arr[i] = pq->arr[pa];
+		i = pa;
 	}
+	pq->arr[i] = nuevo;
 }
 
 /* Realiza la operacion de propagar abajo
@@ -130,28 +160,57 @@ https://pages.cs.wisc.edu/~mcw/cs367/lectures/heaps.html
 void _percolate_down(PQ pq, int i) {
 	if (pq == NULL || i >= pq->size) return; // caso base
 
-	// calcular hijos 
-	int left = i * 2;
-	int right = i * 2 + 1;
-	int lowest = i; // iniciar asumiendo que el padre es el menor
-
-	// si el hijo izq existe y es menor al padre, es lowest actual 
-	if (left <= pq->size && pq->arr[left]->prio < pq->arr[lowest]->prio) {
-		lowest = left;
-	}
-	// luego, verificar si el derecho existe y si es menor a lowest actual
-	if (right <= pq->size && pq->arr[right]->prio < pq->arr[lowest]->prio) {
-		lowest = right;
+	struct _PrioValue actual = pq->arr[i];
+	while (1) {
+		// calcular hijos, estan todos juntos en la misma linea de cache
+		int first = i * PQ_ARIDAD + 1;
+		int last = first + PQ_ARIDAD;
+		int lowest = first;
+
+		if (first >= pq->size) break;
+		if (last > pq->size) last = pq->size;
+		// buscar el menor de los hijos que existen
+		for (int h = first + 1; h < last; h++) {
+			if (pq->arr[h].prio < pq->arr[lowest].prio) {
+				lowest = h;
+			}
+		}
+		// si el menor hijo no es menor al que baja, ya esta en su lugar
+		if (pq->arr[lowest].prio >= actual.prio) break;
+		pq->arr[i] = pq->arr[lowest];
+		i = lowest;
 	}
+	pq->arr[i] = actual;
+}
 
-	// si lowest es diferente al padre, intercambiamos y propagamos abajo
-	if (lowest != i) {
-		PrioValue temp = pq->arr[i];
-		pq->arr[i] = pq->arr[lowest];
-		pq->arr[lowest] = temp;
-		_percolate_down(pq, lowest);
+/* Duplica la capacidad del arreglo hasta que entren minimo elementos
+retorna TRUE si tuvo exito */
+static BOOLEAN _agrandar(PQ pq, int minimo) {
+	int cap = pq->cap > 0 ? pq->cap : INITIAL_CAP;
+	while (cap < minimo) cap *= 2;
+
+	// realloc no respeta la alineacion, se copia a un bloque nuevo
+	// (PQ_ARIDAD - 1 lugares extra al inicio y una linea de cache para alinear)
+	size_t tam = sizeof(struct _PrioValue) * (cap + PQ_ARIDAD - 1) + LINEA_CACHE;
+	void* mem = pq->arena != NULL ? arena_pedir(pq->arena, tam) : malloc(tam);
+	if (mem == NULL) return FALSE;
+	struct _PrioValue* arr = _alinear(mem);
+	if (pq->size > 0) {
+		memcpy(arr, pq->arr, sizeof(struct _PrioValue) * pq->size);
 	}
+	// el arreglo viejo de una arena queda ahi hasta que se vacie
+	if (pq->arena == NULL) free(pq->mem);
+	pq->mem = mem;
+	pq->arr = arr;
+	pq->cap = cap;
+	return TRUE;
+}
 
+/* Ubica arr dentro de mem para que los hijos de cada nodo (desde PQ_ARIDAD*i+1)
+empiecen en un multiplo de 64 bytes */
+static struct _PrioValue* _alinear(void* mem) {
+	size_t dir = ((size_t)mem + LINEA_CACHE - 1) & ~(size_t)(LINEA_CACHE - 1);
+	return (struct _PrioValue*)dir + (PQ_ARIDAD - 1);
 }
 
 /* Imprime un PQ de chars con el formato valor = prioridad */
@@ -159,17 +218,17 @@ void print_pq(PQ pq) {
 	if (pq == NULL) return;
 	printf("\n");
 	// recorrer la pq e imprimir cada valor
-	for (int i = 1; i <= pq->size; i++) {
+	for (int i = 0; i < pq->size; i++) {
 		// acceder al valor del puntero value como un char
-		char ch = *(char*)(pq->arr[i]->value);
+		char ch = *(char*)(pq->arr[i].value);
 		if (ch == ' ') {
-			printf("\n espacio = %d", pq->arr[i]->prio);
+			printf("\n espacio = %d", pq->arr[i].prio);
 		}
 		else if (ch == '\n') {
-			printf("\n newline = %d", pq->arr[i]->prio);
+			printf("\n newline = %d", pq->arr[i].prio);
 		}
 		else {
-			printf("\n%c = %d", ch, pq->arr[i]->prio);
+			printf("\n%c = %d", ch, pq->arr[i].prio);
 		}
 	}
 }
@@ -1,6 +1,8 @@
 #ifndef DEFINE_PQ_H
 #define DEFINE_PQ_H
 
+#include "arena.h"
+
 /*Definicion del API de la cola de prioridades, la implementacion va en pq.c*/
 
 /* macros de definicion de tipos de datos boolean */
@@ -10,19 +12,32 @@
 
 /* Implementacion de una cola de prioridades usando un Monticulo (Heap) */
 
+/* cantidad de hijos de cada nodo del monticulo, se elige al compilar (-DPQ_ARIDAD=2 para el binario)
+con 4 hijos y PrioValues de 16 bytes los hijos de un nodo ocupan exactamente una linea de cache de 64 bytes */
+#ifndef PQ_ARIDAD
+#define PQ_ARIDAD 4
+#endif
+
 /* PrioValue es un contenedor para almacenar la combinacion de Prioridad+Valor dentro del arreglo*/
 // agregue un campo int es_arbol para facilitar el manejo de chars vs arboles en la pq
+// la prioridad va junto al valor y en el orden que deja el struct en 16 bytes (sin relleno)
 typedef struct _PrioValue {
 	int prio;
-	void* value;
 	int es_arbol;
+	void* value;
 }*PrioValue;
 
-/*Heap es la estructura que contiene el arreglo (de PrioValues), la capacidad del arreglo y el tamano del monticulo */
+/*Heap es la estructura que contiene el arreglo (de PrioValues), la capacidad del arreglo y el tamano del monticulo
+Los PrioValue se guardan directamente dentro del arreglo (no punteros), el arreglo crece al doble cuando se llena
+la cima esta en arr[0] y los hijos de i en PQ_ARIDAD*i+1 .. PQ_ARIDAD*i+PQ_ARIDAD
+arr esta corrido dentro de mem para que cada grupo de hermanos empiece alineado a 64 bytes
+si arena no es NULL el heap y el arreglo salen de ahi y se liberan con la arena */
 typedef struct Heap {
-	PrioValue* arr;
+	struct _PrioValue* arr;
+	void* mem;
 	int cap;
 	int size;
+	Arena arena;
 }*PQ;
 
 
@@ -31,6 +46,11 @@ retorna un puntero a la cola de prioridad
 retorna NULL si hubo error*/
 PQ pq_create();
 
+/* Como pq_create pero toda la memoria de la cola se pide a la arena
+(pq_destroy no libera nada, se libera con arena_vaciar o arena_destruir)
+retorna NULL si hubo error*/
+PQ pq_create_arena(Arena arena);
+
 
 /*
   Agrega un valor a la cola con la prioridad dada
@@ -40,11 +60,18 @@ PQ pq_create();
 BOOLEAN pq_add(PQ pq, void* valor, int prioridad, int es_arbol);
 
 /*
-Saca el valor de menor prioridad (cima del monticulo) y lo guarda en la posicion retVal (paso por referencia)
-retorna FALSE si tiene un error
+Saca el valor de menor prioridad (cima del monticulo) y copia su PrioValue en retVal (paso por referencia)
+retorna FALSE si tiene un error o si la cola esta vacia
 retorna TRUE si tuvo EXITO
 */
-BOOLEAN pq_remove(PQ pq, void** retVal);
+BOOLEAN pq_remove(PQ pq, PrioValue retVal);
+
+/*
+Agrega n elementos de una vez y reordena todo el monticulo en O(n)
+(en vez de n llamadas a pq_add de O(log n) cada una)
+retorna TRUE si tuvo exito, FALSE si no
+*/
+BOOLEAN pq_heapify(PQ pq, const struct _PrioValue* elementos, int n);
 
 /* retorna el tamao de la cola de prioridad,
 retorna 0 si hubo error
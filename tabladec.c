@@ -0,0 +1,233 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "tabladec.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int _reservar(TablaDec t, int cantidad);
+static int _llenar(TablaDec t, int base, int b, int consumidos, const unsigned int* codigos, const unsigned char* longitudes, int* lista, int cant);
+static void _emparejar(TablaDec t);
+static void* _pedir(TablaDec t, size_t tam);
+static void _liberar(TablaDec t, void* p);
+
+/*
+  Crea la tabla de decodificacion a partir del codigo de cada simbolo.
+  retorna NULL si hubo error
+*/
+TablaDec tabladec_crear(const unsigned int* codigos, const unsigned char* longitudes, int num_simbolos, int bits_primaria) {
+	return tabladec_crear_arena(codigos, longitudes, num_simbolos, bits_primaria, NULL);
+}
+
+/*
+  Como tabladec_crear pero toda la memoria se pide a la arena (NULL = malloc)
+  retorna NULL si hubo error
+*/
+TablaDec tabladec_crear_arena(const unsigned int* codigos, const unsigned char* longitudes, int num_simbolos, int bits_primaria, Arena arena) {
+	// validar argumentos
+	if (codigos == NULL || longitudes == NULL) return NULL;
+	if (num_simbolos <= 0 || bits_primaria <= 0 || bits_primaria > 16) return NULL;
+
+	TablaDec t = (TablaDec)(arena != NULL ? arena_pedir(arena, sizeof(struct _TablaDec)) : malloc(sizeof(struct _TablaDec)));
+	if (t == NULL) return NULL;
+	t->bits_primaria = bits_primaria;
+	t->num_entradas = 0;
+	t->cap = 0;
+	t->entradas = NULL;
+	t->max_longitud = 0;
+	t->arena = arena;
+
+	// lista de simbolos que tienen codigo
+	int* lista = _pedir(t, sizeof(int) * num_simbolos);
+	if (lista == NULL) {
+		tabladec_destruir(t);
+		return NULL;
+	}
+	int cant = 0;
+	for (int s = 0; s < num_simbolos; s++) {
+		if (longitudes[s] == 0) continue;
+		if (longitudes[s] > 32) { // no entra en un campobits
+			_liberar(t, lista);
+			tabladec_destruir(t);
+			return NULL;
+		}
+		if (longitudes[s] > t->max_longitud) t->max_longitud = longitudes[s];
+		lista[cant++] = s;
+	}
+
+	// la tabla primaria va al inicio del arreglo y las subtablas se agregan detras
+	if (_reservar(t, 1 << bits_primaria) < 0 || !_llenar(t, 0, bits_primaria, 0, codigos, longitudes, lista, cant)) {
+		_liberar(t, lista);
+		tabladec_destruir(t);
+		return NULL;
+	}
+	_liberar(t, lista);
+
+	_emparejar(t);
+	return t;
+}
+
+/*
+  Resuelve una entrada que apunta a una subtabla, bajando por las subtablas
+  encadenadas hasta llegar a un simbolo.
+  Si la entrada no lleva a ningun simbolo (codigo invalido) retorna una entrada con nsim == 0
+*/
+EntradaDec tabladec_subtabla(TablaDec t, EntradaDec e, unsigned long long acc, int* usados) {
+	int nivel = t->bits_primaria;
+	int u = 0;
+	while (e.nsim == 0 && e.bits > 0) {
+		u += nivel;
+		nivel = e.bits;
+		e = t->entradas[e.valor + (unsigned int)((acc >> u) & ((1u << nivel) - 1))];
+	}
+	*usados = u;
+	return e;
+}
+
+/* Destruye la tabla */
+void tabladec_destruir(TablaDec t) {
+	if (t == NULL || t->arena != NULL) return;
+	free(t->entradas);
+	free(t);
+}
+
+// FUNCIONES ADICIONALES -----------
+
+/* Agrega cantidad entradas vacias al final del arreglo, agrandandolo si hace falta
+retorna el indice de la primera entrada nueva, -1 si hubo error */
+static int _reservar(TablaDec t, int cantidad) {
+	if (t->num_entradas + cantidad > t->cap) {
+		int nueva = t->cap == 0 ? cantidad : t->cap * 2;
+		while (nueva < t->num_entradas + cantidad) nueva *= 2;
+		EntradaDec* arr = NULL;
+		if (t->arena != NULL) {
+			// en la arena no hay realloc: se copia y el arreglo viejo queda hasta que se vacie
+			arr = arena_pedir(t->arena, sizeof(EntradaDec) * nueva);
+			if (arr != NULL && t->num_entradas > 0) memcpy(arr, t->entradas, sizeof(EntradaDec) * t->num_entradas);
+		}
+		else {
+			arr = realloc(t->entradas, sizeof(EntradaDec) * nueva);
+		}
+		if (arr == NULL) return -1;
+		t->entradas = arr;
+		t->cap = nueva;
+	}
+	int inicio = t->num_entradas;
+	memset(t->entradas + inicio, 0, sizeof(EntradaDec) * cantidad);
+	t->num_entradas += cantidad;
+	return inicio;
+}
+
+/*
+  Llena la tabla de b bits de indice que empieza en base con los simbolos de lista,
+  de los que ya se consumieron los primeros 'consumidos' bits.
+  Los codigos que no entran en b bits se agrupan por su indice y van a una subtabla.
+  retorna 0 si los codigos no son validos
+*/
+static int _llenar(TablaDec t, int base, int b, int consumidos, const unsigned int* codigos, const unsigned char* longitudes, int* lista, int cant) {
+	int tam = 1 << b;
+	int largos = 0;
+
+	// los codigos cortos se repiten en todos los indices que empiezan con ellos
+	for (int i = 0; i < cant; i++) {
+		int s = lista[i];
+		int l = longitudes[s] - consumidos;
+		if (l > b) {
+			largos++;
+			continue;
+		}
+		unsigned int c = (unsigned int)(((unsigned long long)codigos[s] >> consumidos) & ((1u << l) - 1));
+		for (unsigned int k = c; k < (unsigned int)tam; k += 1u << l) {
+			EntradaDec* e = &t->entradas[base + k];
+			if (e->nsim != 0 || e->bits != 0) return 0; // dos codigos con el mismo prefijo
+			e->valor = (unsigned int)s;
+			e->nsim = 1;
+			e->bits = (unsigned char)l;
+			e->bits1 = (unsigned char)l;
+		}
+	}
+	if (largos == 0) return 1;
+
+	// agrupar los codigos largos por indice (ordenamiento por conteo)
+	int* cuenta = _pedir(t, sizeof(int) * (tam + 1));
+	int* orden = _pedir(t, sizeof(int) * largos);
+	if (cuenta == NULL || orden == NULL) {
+		_liberar(t, cuenta);
+		_liberar(t, orden);
+		return 0;
+	}
+	memset(cuenta, 0, sizeof(int) * (tam + 1));
+	for (int i = 0; i < cant; i++) {
+		int s = lista[i];
+		if (longitudes[s] - consumidos <= b) continue;
+		cuenta[((codigos[s] >> consumidos) & (tam - 1)) + 1]++;
+	}
+	for (int k = 0; k < tam; k++) cuenta[k + 1] += cuenta[k];
+	for (int i = 0; i < cant; i++) {
+		int s = lista[i];
+		if (longitudes[s] - consumidos <= b) continue;
+		orden[cuenta[(codigos[s] >> consumidos) & (tam - 1)]++] = s;
+	}
+
+	// cada grupo recibe su propia subtabla
+	int ok = 1;
+	int inicio = 0;
+	while (ok && inicio < largos) {
+		unsigned int k = (codigos[orden[inicio]] >> consumidos) & (tam - 1);
+		int fin = inicio;
+		int max = 0;
+		while (fin < largos && ((codigos[orden[fin]] >> consumidos) & (tam - 1)) == k) {
+			if (longitudes[orden[fin]] > max) max = longitudes[orden[fin]];
+			fin++;
+		}
+		int sb = max - consumidos - b;
+		if (sb > TABLADEC_BITS_SUB) sb = TABLADEC_BITS_SUB;
+
+		if (t->entradas[base + k].nsim != 0) {
+			ok = 0; // un codigo corto es prefijo de uno largo
+			break;
+		}
+		int sub = _reservar(t, 1 << sb);
+		if (sub < 0) {
+			ok = 0;
+			break;
+		}
+		EntradaDec* e = &t->entradas[base + k];
+		e->valor = (unsigned int)sub;
+		e->nsim = 0;
+		e->bits = (unsigned char)sb;
+		ok = _llenar(t, sub, sb, consumidos + b, codigos, longitudes, orden + inicio, fin - inicio);
+		inicio = fin;
+	}
+	_liberar(t, cuenta);
+	_liberar(t, orden);
+	return ok;
+}
+
+/*
+  Si despues del primer simbolo de una entrada primaria quedan bits
+  suficientes para otro codigo completo, la entrada devuelve los dos simbolos.
+*/
+static void _emparejar(TablaDec t) {
+	int tam = 1 << t->bits_primaria;
+	for (int k = 0; k < tam; k++) {
+		EntradaDec* e = &t->entradas[k];
+		if (e->nsim != 1 || e->valor > 0xFFFF) continue;
+		int resto = t->bits_primaria - e->bits1;
+		if (resto <= 0) continue;
+		// los bits que siguen al primer codigo, los desconocidos quedan en 0
+		EntradaDec e2 = t->entradas[k >> e->bits1];
+		if (e2.nsim == 0 || e2.bits1 > resto || (e2.nsim == 1 && e2.valor > 0xFFFF)) continue;
+		e->valor = e->valor | ((e2.valor & 0xFFFF) << 16);
+		e->nsim = 2;
+		e->bits = (unsigned char)(e->bits1 + e2.bits1);
+	}
+}
+
+/* Pide tam bytes de memoria de trabajo a la arena de la tabla o a malloc */
+static void* _pedir(TablaDec t, size_t tam) {
+	return t->arena != NULL ? arena_pedir(t->arena, tam) : malloc(tam);
+}
+
+/* Libera lo pedido con _pedir (lo de la arena se libera con ella) */
+static void _liberar(TablaDec t, void* p) {
+	if (t->arena == NULL) free(p);
+}
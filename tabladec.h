@@ -0,0 +1,70 @@
+#ifndef DEFINE_TABLADEC_H
+#define DEFINE_TABLADEC_H
+
+#include "arena.h"
+
+/*Definicion del API de las tablas de decodificacion, la implementacion va en tabladec.c*/
+
+/*
+  En lugar de recorrer el arbol bit por bit, el decodificador mira los
+  siguientes bits_primaria bits del flujo (el primer bit en la posicion 0,
+  igual que en campobits) y los usa como indice de una tabla.
+  Cada entrada dice que simbolo(s) se obtienen y cuantos bits consumir.
+  Los codigos mas largos que bits_primaria continuan en subtablas.
+*/
+
+/* cantidad de bits de la tabla primaria por defecto */
+#define TABLADEC_BITS 11
+
+/* maximo de bits de indice de una subtabla, los codigos mas largos encadenan subtablas */
+#define TABLADEC_BITS_SUB 8
+
+/*
+EntradaDec es una entrada de la tabla:
+  nsim == 1: valor es el simbolo
+  nsim == 2: valor tiene el primer simbolo en los 16 bits bajos y el segundo en los altos
+  nsim == 0: valor es el indice donde empieza la subtabla y bits la cantidad de bits de indice de la subtabla
+bits es la cantidad de bits que consume la entrada, bits1 los que consume solo el primer simbolo
+*/
+typedef struct _EntradaDec {
+	unsigned int valor;
+	unsigned char nsim;
+	unsigned char bits;
+	unsigned char bits1;
+	unsigned char reservado;
+} EntradaDec;
+
+/* TablaDec contiene la tabla primaria seguida de todas las subtablas en un solo arreglo
+si arena no es NULL toda su memoria sale de ahi */
+typedef struct _TablaDec {
+	EntradaDec* entradas;
+	int bits_primaria;
+	int num_entradas;
+	int cap;
+	int max_longitud;
+	Arena arena;
+}*TablaDec;
+
+/*
+  Crea la tabla de decodificacion a partir del codigo de cada simbolo.
+  codigos[s] tiene el primer bit del codigo en la posicion 0 (como campobits)
+  longitudes[s] es el tamano del codigo, 0 si el simbolo no se usa
+  retorna NULL si hubo error (por ejemplo si los codigos no son libres de prefijo)
+*/
+TablaDec tabladec_crear(const unsigned int* codigos, const unsigned char* longitudes, int num_simbolos, int bits_primaria);
+
+/* Como tabladec_crear pero toda la memoria se pide a la arena
+(tabladec_destruir no libera nada, se libera con la arena) */
+TablaDec tabladec_crear_arena(const unsigned int* codigos, const unsigned char* longitudes, int num_simbolos, int bits_primaria, Arena arena);
+
+/*
+  Resuelve una entrada que apunta a una subtabla.
+  acc son los bits pendientes del flujo (el siguiente bit en la posicion 0)
+  retorna la entrada final y guarda en *usados los bits de indice consumidos antes de ella
+*/
+EntradaDec tabladec_subtabla(TablaDec t, EntradaDec e, unsigned long long acc, int* usados);
+
+/* Destruye la tabla */
+void tabladec_destruir(TablaDec t);
+
+#endif